@@ -3,13 +3,31 @@
 //
 #include <csv_co/reader.hpp>
 #include <iostream>
+#include <numeric>
+#include <charconv>
+#include <cstring>
 
 using namespace csv_co;
+
+// Counts of a part of a source, made by the part's own thread. Parts count on cache lines of their own, so threads
+// never write next to each other while they count.
+struct alignas(64) part_counts {
+    std::size_t cells {0};
+    std::size_t rows {0};
+};
+
 int main(int argc, char ** argv)
 {
-    if (argc != 2)
+    // Threads, all chars of the argument being the number
+    std::size_t threads {0};
+    auto const threads_given = [&] {
+        auto const end = argv[2] + std::strlen(argv[2]);
+        auto const [last, error] = std::from_chars(argv[2], end, threads);
+        return error == std::errc{} && last == end;
+    };
+    if ((argc != 2 && argc != 3) || (argc == 3 && !threads_given()))
     {
-        std::cout << "Usage: ./spanbench <csv_file>\n";
+        std::cout << "Usage: ./spanbench <csv_file> [threads (0 - all hardware ones)]\n";
         return EXIT_FAILURE;
     }
 
@@ -19,8 +37,8 @@ int main(int argc, char ** argv)
     try
     {
 
-        auto cells{0u};
-        auto rows {0u};
+        std::size_t cells {0};
+        std::size_t rows {0};
 
         auto save_num_exp = num_exp;
         while (num_exp--)
@@ -28,7 +46,20 @@ int main(int argc, char ** argv)
             auto const begin = std::chrono::high_resolution_clock::now();
             cells = rows = 0;
             reader r (std::filesystem::path {argv[1]});
-            r.run_span([&cells](auto &s) { cells++; }, [&rows] { rows++; });
+            if (argc == 2)
+            {
+                r.run_span([&cells](auto &s) { cells++; }, [&rows] { rows++; });
+            } else
+            {
+                // Per-part counts are summed up afterwards, no locking. There are as many parts as threads at most
+                std::vector<part_counts> parts (threads ? threads : std::max(1u, std::thread::hardware_concurrency()));
+                r.run_span_parallel(threads, [&parts](auto &s, auto part) { parts[part].cells++; },
+                                    [&parts](auto part) { parts[part].rows++; });
+                cells = std::accumulate(parts.begin(), parts.end(), std::size_t{0},
+                                        [](auto sum, auto const & p) { return sum + p.cells; });
+                rows = std::accumulate(parts.begin(), parts.end(), std::size_t{0},
+                                       [](auto sum, auto const & p) { return sum + p.rows; });
+            }
             auto const end = std::chrono::high_resolution_clock::now();
             accum_times += std::chrono::duration_cast<std::chrono::milliseconds>(end-begin).count();
         }
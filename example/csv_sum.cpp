@@ -11,18 +11,13 @@ int main() {
     try {
         reader r(std::filesystem::path("smallpop.csv"));
 
-        constexpr unsigned population_col = 3;
         auto sum = 0u;
 
-        r.valid().run_span(
-                [](auto) {}, [&sum](auto &s) {
-                    static auto col{0u};
-                    if (col++ == population_col) {
-                        col = 0;
-                        cell_string value;
-                        s.read_value(value);
-                        sum += std::stoi(value);
-                    }
+        // the population column only, selected by its header's name
+        r.valid().run_span({"population"}, [&sum](auto &s) {
+                    unsigned value;
+                    s.read_value(value);
+                    sum += value;
                 });
         std::cout << "Total population is: " << sum << std::endl;
     } catch (reader<>::exception const & e)
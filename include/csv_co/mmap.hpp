@@ -25,7 +25,9 @@
 #ifndef MIO_MMAP_HEADER
 #define MIO_MMAP_HEADER
 
+#include <algorithm>
 #include <iterator>
+#include <span>
 #include <string>
 #include <system_error>
 #include <cstdint>
@@ -53,6 +55,22 @@ namespace mio {
 
     constexpr int read_access_mode = 0;
 
+    // Advice to the kernel on how a mapping is going to be read. Advice only: ignored where it is not supported
+    // (and on Windows at all), so a mapping never fails because of it.
+    struct access_hints
+    {
+        // MADV_SEQUENTIAL: aggressive read-ahead, pages behind are freed sooner
+        bool sequential = false;
+        // MADV_WILLNEED: starts reading the whole mapping in at once
+        bool will_need = false;
+        // MAP_POPULATE: the mapping is faulted in before map() returns
+        bool populate = false;
+        // MADV_HUGEPAGE: transparent huge pages, if the file system provides them
+        bool huge_pages = false;
+        // MADV_DONTNEED: ranges passed to ro_mmap::drop() leave the resident set of the process (not the page cache)
+        bool drop_consumed = false;
+    };
+
     struct ro_mmap
     {
         using value_type = char; //std::byte;
@@ -75,6 +93,7 @@ namespace mio {
         handle_type file_mapping_handle_ = INVALID_HANDLE_VALUE;
 #endif
         bool is_handle_internal_{};
+        access_hints hints_{};
 
     public:
         ro_mmap() = default;
@@ -96,6 +115,7 @@ namespace mio {
             std::swap(file_mapping_handle_,o.file_mapping_handle_);
 #endif
             std::swap(is_handle_internal_,o.is_handle_internal_);
+            std::swap(hints_,o.hints_);
         }
 
         ro_mmap& operator=(ro_mmap && o) noexcept
@@ -128,21 +148,27 @@ namespace mio {
         reference operator[](const size_type i) noexcept { return data_[i]; }
         const_reference operator[](const size_type i) const noexcept { return data_[i]; }
 
+        [[nodiscard]] access_hints hints() const noexcept { return hints_; }
+
         template<typename String>
         void map(const String& path, size_type offset,
-                 size_type length, std::error_code& error);
+                 size_type length, std::error_code& error, access_hints hints = {});
 
         template<typename String>
-        void map(const String& path, std::error_code& error)
+        void map(const String& path, std::error_code& error, access_hints hints = {})
         {
-            map(path, 0, map_entire_file, error);
+            map(path, 0, map_entire_file, error, hints);
         }
 
         void map(handle_type handle, size_type offset,
-                 size_type length, std::error_code& error);
+                 size_type length, std::error_code& error, access_hints hints = {});
 
         void unmap();
 
+        // Unmaps whole pages of [first, last) from the process if mapped with drop_consumed. They are faulted in
+        // again if touched.
+        void drop(const_pointer first, const_pointer last) const noexcept;
+
     private:
         [[nodiscard]] const_pointer get_mapping_start() const noexcept
         {
@@ -150,6 +176,70 @@ namespace mio {
         }
     };
 
+    // Size of windows of a file mapped by windows
+    struct sliding_window
+    {
+        size_t size = 64 * 1024 * 1024;
+    };
+
+    // A file mapped window by window, one at a time: address space and resident pages of the file stay
+    // within (about) a window whatever its size. Windows begin at pages, and grow to take longer ranges.
+    struct ro_mmap_windows
+    {
+        using value_type = char;
+        using size_type = size_t;
+        using handle_type = file_handle_type;
+
+    private:
+        handle_type file_handle_ = INVALID_HANDLE_VALUE;
+        size_type size_ = 0;
+        size_type window_size_ = 0;
+        access_hints hints_{};
+        mutable ro_mmap window_;
+        mutable std::error_code error_;
+
+    public:
+        ro_mmap_windows() = default;
+        ro_mmap_windows(const ro_mmap_windows&) = delete;
+        ro_mmap_windows& operator=(const ro_mmap_windows&) = delete;
+
+        ro_mmap_windows(ro_mmap_windows && o) noexcept : ro_mmap_windows()
+        {
+            Swap(o);
+        }
+
+        void Swap (ro_mmap_windows & o) noexcept
+        {
+            std::swap(file_handle_,o.file_handle_);
+            std::swap(size_,o.size_);
+            std::swap(window_size_,o.window_size_);
+            std::swap(hints_,o.hints_);
+            window_.Swap(o.window_);
+            std::swap(error_,o.error_);
+        }
+
+        ro_mmap_windows& operator=(ro_mmap_windows && o) noexcept
+        {
+            ro_mmap_windows tmp(std::move(o));
+            Swap(tmp);
+            return *this;
+        }
+
+        ~ro_mmap_windows();
+
+        [[nodiscard]] bool is_open() const noexcept { return file_handle_ != invalid_handle; }
+        [[nodiscard]] size_type size() const noexcept { return size_; }
+        // The first error of mapping a window, if any
+        [[nodiscard]] std::error_code error() const noexcept { return error_; }
+
+        template<typename String>
+        void open(const String& path, sliding_window window, std::error_code& error, access_hints hints = {});
+
+        // Maps a window taking [first, from] at least (from < size()), and returns its part from first.
+        // The previous window is unmapped. Empty on errors: see error().
+        [[nodiscard]] std::span<const value_type> window(size_type first, size_type from) const noexcept;
+    };
+
 } // namespace mio
 
 // implementation details
@@ -381,7 +471,8 @@ namespace mio {
         }
 
         inline mmap_context memory_map(const file_handle_type file_handle, const int64_t offset,
-                                       const int64_t length, const int /*access_mode mode*/, std::error_code& error)
+                                       const int64_t length, const int /*access_mode mode*/,
+                                       [[maybe_unused]] const access_hints hints, std::error_code& error)
         {
             const int64_t aligned_offset = make_offset_page_aligned(offset);
             const int64_t length_to_map = offset - aligned_offset + length;
@@ -413,11 +504,15 @@ namespace mio {
                 return {};
             }
 #else // POSIX
+            int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+            if(hints.populate) { flags |= MAP_POPULATE; }
+#endif
             char* mapping_start = static_cast<char*>(::mmap(
                     nullptr, // Don't give hint as to where to map.
                     length_to_map,
                     PROT_READ,
-                    MAP_SHARED,
+                    flags,
                     file_handle,
                     aligned_offset));
             if(mapping_start == MAP_FAILED)
@@ -425,6 +520,12 @@ namespace mio {
                 error = detail::last_error();
                 return {};
             }
+            // Errors of advice are of no consequence
+#ifdef MADV_HUGEPAGE
+            if(hints.huge_pages) { ::madvise(mapping_start, length_to_map, MADV_HUGEPAGE); }
+#endif
+            if(hints.sequential) { ::madvise(mapping_start, length_to_map, MADV_SEQUENTIAL); }
+            if(hints.will_need) { ::madvise(mapping_start, length_to_map, MADV_WILLNEED); }
 #endif
             mmap_context ctx {mapping_start + offset - aligned_offset, length, length_to_map
 #ifdef _WIN32
@@ -446,7 +547,7 @@ namespace mio {
 
     template<typename String>
     void ro_mmap::map(const String& path, const size_type offset,
-                                         const size_type length, std::error_code& error)
+                                         const size_type length, std::error_code& error, const access_hints hints)
     {
         error.clear();
         if(detail::empty(path))
@@ -460,7 +561,7 @@ namespace mio {
             return;
         }
 
-        map(handle, offset, length, error);
+        map(handle, offset, length, error, hints);
         if(!error)
         {
             is_handle_internal_ = true;
@@ -468,7 +569,8 @@ namespace mio {
     }
 
     void ro_mmap::map(const handle_type handle,
-                                         const size_type offset, const size_type length, std::error_code& error)
+                                         const size_type offset, const size_type length, std::error_code& error,
+                                         const access_hints hints)
     {
         error.clear();
         if(handle == invalid_handle)
@@ -491,12 +593,13 @@ namespace mio {
 
         const auto ctx = detail::memory_map(handle, offset,
                                             length == map_entire_file ? (file_size - offset) : length,
-                                            read_access_mode, error);
+                                            read_access_mode, hints, error);
         if(!error)
         {
             unmap();
             file_handle_ = handle;
             is_handle_internal_ = false;
+            hints_ = hints;
             data_ = reinterpret_cast<pointer>(ctx.data);
             length_ = ctx.length;
             mapped_length_ = ctx.mapped_length;
@@ -537,6 +640,83 @@ namespace mio {
 #endif
     }
 
+    void ro_mmap::drop([[maybe_unused]] const const_pointer first, [[maybe_unused]] const const_pointer last) const noexcept
+    {
+#ifndef _WIN32
+        if(!hints_.drop_consumed || !data_) { return; }
+        // Pages lying within the range only
+        const auto start = get_mapping_start();
+        const auto page_size = detail::page_size();
+        const auto from = (static_cast<size_t>(first - start) + page_size - 1) / page_size * page_size;
+        const auto to = detail::make_offset_page_aligned(static_cast<size_t>(last - start));
+        if(from < to)
+        {
+            ::madvise(const_cast<pointer>(start) + from, to - from, MADV_DONTNEED);
+        }
+#endif
+    }
+
+// -- ro_mmap_windows --
+
+    ro_mmap_windows::~ro_mmap_windows()
+    {
+        window_.unmap();
+        if(is_open())
+        {
+#ifdef _WIN32
+            ::CloseHandle(file_handle_);
+#else // POSIX
+            ::close(file_handle_);
+#endif
+        }
+    }
+
+    template<typename String>
+    void ro_mmap_windows::open(const String& path, const sliding_window window,
+                               std::error_code& error, const access_hints hints)
+    {
+        error.clear();
+        const auto handle = detail::open_file(path, read_access_mode, error);
+        if(error)
+        {
+            return;
+        }
+        const auto file_size = detail::query_file_size(handle, error);
+        ro_mmap_windows opened;
+        opened.file_handle_ = handle;
+        if(error)
+        {
+            return;
+        }
+        opened.size_ = file_size;
+        // Whole pages, one at least
+        const auto page_size = detail::page_size();
+        opened.window_size_ = std::max(page_size, detail::make_offset_page_aligned(window.size));
+        opened.hints_ = hints;
+        Swap(opened);
+    }
+
+    std::span<const ro_mmap_windows::value_type> ro_mmap_windows::window(const size_type first,
+                                                                        const size_type from) const noexcept
+    {
+        if(error_ || from >= size_)
+        {
+            return {};
+        }
+        const auto start = detail::make_offset_page_aligned(first);
+        auto length = window_size_;
+        while(start + length <= from)
+        {
+            length *= 2;
+        }
+        window_.map(file_handle_, start, std::min(length, size_ - start), error_, hints_);
+        if(error_)
+        {
+            return {};
+        }
+        return {window_.data() + (first - start), window_.size() - (first - start)};
+    }
+
     bool ro_mmap::is_mapped() const noexcept
     {
 #ifdef _WIN32
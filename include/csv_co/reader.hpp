@@ -1,7 +1,8 @@
 #pragma once
 
-#include "short_alloc.h"
 #include "mmap.hpp"
+#include "simd.hpp"
+#include "stream.hpp"
 
 #if (IS_CLANG==0)
 #ifdef __has_include
@@ -26,25 +27,93 @@
     #endif
 #endif
 
+#include <cassert>
 #include <optional>
 #include <functional>
 #include <filesystem>
 #include <concepts>
 #include <variant>
+#include <span>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <bit>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <array>
+#include <system_error>
+#include <charconv>
+#if !defined(__cpp_lib_to_chars)
+#include <sstream>
+#include <locale>
+#endif
+#include <iterator>
+#include <memory>
+#include <new>
+#include <fstream>
 
-template <std::size_t N = 1000>
-constexpr const std::size_t coroutine_arena_max_alloc = N;
-static arena<coroutine_arena_max_alloc<>, alignof(std::max_align_t)> coroutine_arena;
+namespace csv_co {
 
-static void* coro_alloc(size_t sz) noexcept {
-    return coroutine_arena.template allocate<alignof(std::max_align_t)>(sz * sizeof(char));
-}
+    // Coroutine frames of a thread, stacked in the thread's own buffer: state machines and senders are created
+    // and destroyed in LIFO order within a call of a reader. Frames not fitting go to the heap, while the depth
+    // of the stack they needed is recorded; the buffer grows to it once no frame is alive.
+    class frame_stack {
+        static constexpr std::size_t alignment = alignof(std::max_align_t);
+        std::unique_ptr<std::byte[]> buf;
+        std::size_t capacity {0};
+        std::size_t top {0};
+        // Bytes of all frames alive (in the buffer or not), and their maximum
+        std::size_t alive {0};
+        std::size_t depth {0};
+
+        static constexpr auto align_up(std::size_t n) noexcept -> std::size_t {
+            return (n + (alignment - 1)) & ~(alignment - 1);
+        }
 
-static void coro_deallocate(void* ptr, size_t sz) noexcept {
-    coroutine_arena.deallocate(reinterpret_cast<char*>(ptr), sz * sizeof(char));
-}
+        [[nodiscard]] auto in_buffer(std::byte const * p) const noexcept -> bool {
+            return std::less_equal<>{}(buf.get(), p) && std::less<>{}(p, buf.get() + capacity);
+        }
 
-namespace csv_co {
+    public:
+        auto allocate(std::size_t n) -> void * {
+            n = align_up(n);
+            if (!alive && depth > capacity) {
+                buf.reset(new std::byte [depth]);
+                capacity = depth;
+            }
+            alive += n;
+            depth = std::max(depth, alive);
+            if (capacity - top >= n) {
+                auto const p = buf.get() + top;
+                top += n;
+                return p;
+            }
+            return ::operator new(n);
+        }
+
+        void deallocate(void * ptr, std::size_t n) noexcept {
+            n = align_up(n);
+            alive -= n;
+            if (auto const p = static_cast<std::byte *>(ptr); in_buffer(p)) {
+                if (p + n == buf.get() + top) {
+                    top -= n;
+                }
+            } else {
+                ::operator delete(ptr);
+            }
+            // frames freed out of order leave no holes behind for long
+            if (!alive) {
+                top = 0;
+            }
+        }
+
+        static auto of_thread() noexcept -> frame_stack & {
+            thread_local frame_stack stack;
+            return stack;
+        }
+    };
 
     using cell_string = std::basic_string<char, std::char_traits<char>,
 #if (IS_MSVC==1)
@@ -57,9 +126,11 @@ namespace csv_co {
 
 
     namespace trim_policy {
+        // Policies trimming a view (without copying) as well, give values of spans by views: see cell_span::view()
         struct no_trimming {
         public:
             static void trim (cell_string const &) {}
+            static constexpr auto trimmed (std::string_view s) noexcept -> std::string_view { return s; }
         };
 
         template <char const * list>
@@ -69,6 +140,11 @@ namespace csv_co {
                 s.erase(0,s.find_first_not_of(list));
                 s.erase(s.find_last_not_of(list)+1);
             }
+            static constexpr auto trimmed (std::string_view s) noexcept -> std::string_view {
+                auto const first = s.find_first_not_of(list);
+                return first == std::string_view::npos ? s.substr(s.size()) :
+                       s.substr(first, s.find_last_not_of(list) + 1 - first);
+            }
         };
         static char const chars [] = " \t\r";
         using alltrim = trimming<chars>;
@@ -102,6 +178,10 @@ namespace csv_co {
         { t } -> std::convertible_to<delimiter<T::value>>;
     };
 
+    // Numbers taken from fields by std::from_chars
+    template <class T>
+    concept NumberConcept = (std::integral<T> && !std::same_as<T, bool>) || std::floating_point<T>;
+
     namespace string_functions {
 
         inline auto devastated(auto const & s) {
@@ -134,8 +214,106 @@ namespace csv_co {
             });
             s.erase(last, s.end());
         }
+
+        // unquote() and unique_quote() in a single pass: copies a field to out (of the field's size at least, or
+        // the field's own chars), but for the quotes of a completely quoted field and for all but one quote of
+        // a run of them. Quote-free runs are copied at once. Returns chars copied.
+        // Unclosed: an opening quote goes without a closing one too (as it does in Ready-value mode).
+        inline auto unescape (std::string_view s, char q, char * out, bool unclosed = false) noexcept -> std::size_t {
+            auto [quoted, opening] = begins_with(s, q);
+            auto closing = std::string_view::npos;
+            if (quoted && devastated(s.substr(s.find_last_of(q) + 1))) {
+                closing = s.find_last_of(q);
+            } else
+            if (!quoted || !unclosed) {
+                opening = std::string_view::npos;
+            }
+            std::size_t n {0};
+            auto after_quote {false};
+            for (std::size_t i = 0; i < s.size(); ) {
+                auto const p = std::min(s.find(q, i), s.size());
+                if (p > i) {
+                    std::char_traits<char>::move(out + n, s.data() + i, p - i);
+                    n += p - i;
+                    after_quote = false;
+                }
+                if (p != s.size() && p != opening && p != closing && !after_quote) {
+                    out[n++] = q;
+                    after_quote = true;
+                }
+                i = p + 1;
+            }
+            return n;
+        }
+
+        // Number of all chars of s, by std::from_chars. Returns an error of the conversion, if any
+        template <NumberConcept T>
+        inline auto to_number(std::string_view s, T & value) noexcept -> std::errc {
+            auto const last = s.data() + s.size();
+#if defined(__cpp_lib_to_chars)
+            auto const [end, error] = std::from_chars(s.data(), last, value);
+#else
+            // Standard libraries lacking std::from_chars of floating point numbers
+            auto const [end, error] = [&]() -> std::from_chars_result {
+                if constexpr (std::floating_point<T>) {
+                    std::istringstream in {std::string(s)};
+                    in.imbue(std::locale::classic());
+                    if (!(in >> value)) {
+                        return {s.data(), std::errc::invalid_argument};
+                    }
+                    return {in.eof() ? last : s.data() + in.tellg(), std::errc{}};
+                } else {
+                    return std::from_chars(s.data(), last, value);
+                }
+            }();
+#endif
+            if (error != std::errc{} || end != last) {
+                value = T{};
+                return error != std::errc{} ? error : std::errc::invalid_argument;
+            }
+            return {};
+        }
     }
 
+    // What callbacks of runs may return to control them (callbacks returning nothing go on to the next field):
+    // skip_row - no more fields of the row are delivered (its end is), stop - the run ends, reading no more
+    enum class control { next, skip_row, stop };
+
+    // Columns selected for runs: by their numbers (from 0), or by names of the header's fields (the first row).
+    // Fields of other columns are neither prepared nor delivered.
+    class columns {
+        std::vector<std::size_t> numbers;
+        std::vector<cell_string> names;
+    public:
+        columns(std::initializer_list<std::size_t> numbers) : numbers(numbers) {}
+        columns(std::initializer_list<std::string_view> names) : names(names.begin(), names.end()) {}
+        explicit columns(std::vector<std::size_t> numbers) noexcept : numbers(std::move(numbers)) {}
+        explicit columns(std::vector<cell_string> names) noexcept : names(std::move(names)) {}
+
+        [[nodiscard]] auto by_names() const noexcept -> bool { return !names.empty(); }
+
+        // Columns selected by numbers, as a mask
+        [[nodiscard]] auto mask() const -> std::vector<bool> {
+            std::vector<bool> result;
+            for (auto const n : numbers) {
+                result.resize(std::max(result.size(), n + 1));
+                result[n] = true;
+            }
+            return result;
+        }
+
+        // Number of a name among the names selected, or none
+        [[nodiscard]] auto named(std::string_view name) const noexcept -> std::optional<std::size_t> {
+            if (auto const it = std::ranges::find(names, name); it != names.end()) {
+                return static_cast<std::size_t>(it - names.begin());
+            }
+            return std::nullopt;
+        }
+
+        [[nodiscard]] auto name(std::size_t i) const noexcept -> cell_string const & { return names[i]; }
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return by_names() ? names.size() : numbers.size(); }
+    };
+
     template <TrimPolicyConcept TrimPolicy = trim_policy::no_trimming
             , QuoteConcept Quote = double_quotes
             , DelimiterConcept Delimiter = comma_delimiter>
@@ -157,11 +335,19 @@ namespace csv_co {
             void                unhandled_exception();
 
             void* operator new(size_t size) noexcept {
-                return coro_alloc(size);
+                if constexpr (G::frames_on_heap) {
+                    return ::operator new(size, std::nothrow);
+                } else {
+                    return frame_stack::of_thread().allocate(size);
+                }
             }
 
             void operator delete(void* ptr, size_t size) {
-                coro_deallocate(ptr, size);
+                if constexpr (G::frames_on_heap) {
+                    ::operator delete(ptr);
+                } else {
+                    frame_stack::of_thread().deallocate(ptr, size);
+                }
             }
 
             static auto get_return_object_on_allocation_failure() {
@@ -226,16 +412,11 @@ namespace csv_co {
                     async_generator,
                     awaitable_promise_type_base<U>>;
             using PromiseTypeHandle = std::coroutine_handle<promise_type>;
+            static constexpr bool frames_on_heap = false;
 
-            T operator()() {
-                auto tmp{std::move(mCoroHdl.promise().mValue)};
-                if constexpr (
-                        std::is_same_v<decltype(mCoroHdl.promise().mValue), std::optional<std::size_t>> ||
-                        std::is_same_v<decltype(mCoroHdl.promise().mValue), std::optional<bool>> )
-                    mCoroHdl.promise().mValue = std::nullopt;
-                else // Single pointer assignment economy :
-                    mCoroHdl.promise().mValue.clear();
-                return tmp;
+            // Every resumption ends up with a (maybe empty) batch, so there is nothing to reset
+            T operator()() const {
+                return mCoroHdl.promise().mValue;
             }
 
             void send(U signal) {
@@ -258,11 +439,14 @@ namespace csv_co {
             PromiseTypeHandle mCoroHdl;
         };
 
-        template<typename T>
+        // Generators outliving a call of a reader (and so maybe destroyed by another thread) keep their frames
+        // on the heap, rather than in the frame stack of the thread creating them
+        template<typename T, bool OnHeap = false>
         struct generator {
             using promise_type      = promise_type_base<T, generator>;
             using PromiseTypeHandle = std::coroutine_handle<promise_type>;
             using iterator          = coro_iterator<promise_type>;
+            static constexpr bool frames_on_heap = OnHeap;
 
             auto begin() -> iterator { return {mCoroHdl}; }
             auto end() -> iterator { return {}; }
@@ -284,12 +468,15 @@ namespace csv_co {
             PromiseTypeHandle mCoroHdl;
         };
 
+        // Parsing protocol: state machines are resumed once per chunk of a source,
+        // and yield batches of whatever they have found in that chunk.
+        using coroutine_stream_type = std::span<mio::ro_mmap::value_type const>;
+        static constexpr std::size_t chunk_size {64 * 1024};
+
         // Parsing State Machines:
-        using FSM = async_generator<cell_string, char>;
-        using FSM_cols = async_generator<std::optional<std::size_t>, char>;
-        using FSM_rows = async_generator<std::optional<bool>, char>;
+        using FSM_cols = async_generator<std::span<std::size_t const>, coroutine_stream_type>;
+        using FSM_rows = async_generator<std::size_t, coroutine_stream_type>;
         class cell_span;
-        using FSM_cell_span = async_generator<cell_span, char>;
 
         // Callback Types:
         using header_field_cb_t = std::function <void (std::string_view value)>;
@@ -297,178 +484,389 @@ namespace csv_co {
         using header_field_span_cb_t = std::function <void (cell_span const & span)>;
         using value_field_span_cb_t = std::function <void (cell_span const & span)>;
         using new_row_cb_t = std::function <void ()>;
+        // Callback Types of parallel Spanning mode, getting a number of the part of a source (and of its thread):
+        using value_field_span_par_cb_t = std::function <void (cell_span const & span, std::size_t part)>;
+        using new_row_par_cb_t = std::function <void (std::size_t part)>;
 
         // Field value getter in run_span()
         class cell_span {
         private:
-            typename cell_string::const_pointer mutable b = nullptr;
+            typename cell_string::const_pointer b = nullptr;
+            // points to the field's limiter, or to the end of the source for the last field
             typename cell_string::const_pointer e = nullptr;
 
-            auto operator()() const noexcept -> bool { return b != nullptr; }
-            void clear () const noexcept {b = nullptr;}
+            friend reader;
 
-            friend auto reader::parse_cell_span() const noexcept -> FSM_cell_span;
-            friend auto reader::run_span(value_field_span_cb_t, new_row_cb_t) const -> void;
-            friend auto reader::run_span(header_field_span_cb_t, value_field_span_cb_t, new_row_cb_t) const -> void;
-            friend auto reader::last_LF(const auto &arg, FSM_cell_span &p) const -> void;
-            template<typename T, typename U>
-            friend struct async_generator;
+            static constexpr bool trims_views = requires (std::string_view v) {
+                { TrimPolicy::trimmed(v) } -> std::convertible_to<std::string_view>;
+            };
         public:
-            void read_value(auto & s) const {
+            // Whether the field has quotes, and so its value is to be unquoted and copied
+            [[nodiscard]] auto quoted() const noexcept -> bool {
                 assert(b!=nullptr && e!=nullptr);
-                using namespace string_functions;
-                // A mangled result string in its guaranteed sufficient space
-                s = std::decay_t<decltype(s)> { b,e };
-                // If the field was (completely) quoted -> it must be unquoted
-                unquote(s, Quote::value);
-                // Fields partly quoted and not-quoted at all: must be spared from double quoting
-                unique_quote(s, Quote::value);
-                TrimPolicy::trim(s);
+                return std::char_traits<char>::find(b, static_cast<std::size_t>(e - b), Quote::value) != nullptr;
             }
-        };
 
-        static constexpr char LF{'\n'};
+            // Value of a field having no quotes: a view into the source, trimmed. UB for quoted fields
+            [[nodiscard]] auto view() const noexcept -> std::string_view requires trims_views {
+                assert(!quoted());
+                return TrimPolicy::trimmed(std::string_view{b, e});
+            }
 
-        [[nodiscard]] inline auto limiter(char b) const noexcept -> bool {
-            return Delimiter::value == b || LF == b;
-        }
+            // Chars of a field in the source: enough for a buffer to unescape it to
+            [[nodiscard]] auto size() const noexcept -> std::size_t {
+                assert(b!=nullptr && e!=nullptr);
+                return static_cast<std::size_t>(e - b);
+            }
+
+            // Value of a field unquoted into a buffer of size() chars at least, in a single pass: a view into it,
+            // trimmed. The buffer is reused by the caller, no allocations are made.
+            [[nodiscard]] auto unescape(std::span<char> buffer) const -> std::string_view requires trims_views {
+                if (buffer.size() < size()) {
+                    throw exception ("Buffer of ", buffer.size(), " chars is less than a field of ", size());
+                }
+                auto const n = string_functions::unescape({b, e}, Quote::value, buffer.data());
+                return TrimPolicy::trimmed({buffer.data(), n});
+            }
 
-        // Coroutine that parses CSV-stream for Ready-value mode
-        #define finalize_field(f) TrimPolicy::trim(f); \
-                                  field.push_back(b);  \
-                                  co_yield field;      \
-                                  field.clear();
+            // Value of a field: a view into the source if the field has no quotes (mostly), or into s,
+            // a buffer to take the unquoted value otherwise (its capacity is reused by the next fields)
+            auto view(auto & s) const -> std::string_view {
+                if constexpr (trims_views) {
+                    if (!quoted()) {
+                        return view();
+                    }
+                    s.resize(size());
+                    return unescape(s);
+                }
+                read_value(s);
+                return {s.data(), s.size()};
+            }
 
-        auto parse() const -> FSM {
-            cell_string field;
-            for(;;) {
-                if (auto b = co_await char{}; !limiter(b) && Quote::value != b) {
-                    field += b;
-                } else
-                if (limiter(b)) {
-                    finalize_field(field)
+            // Number of a field by std::from_chars, from its chars in the source if it has no quotes (mostly),
+            // or from a small buffer it is unquoted to. All of its chars (trimmed) make the number, otherwise
+            // error is std::errc::invalid_argument (or std::errc::result_out_of_range), and 0 is returned.
+            template <NumberConcept T>
+            [[nodiscard]] auto as(std::errc & error) const -> T {
+                assert(b!=nullptr && e!=nullptr);
+                T value {};
+                if constexpr (trims_views) {
+                    if (!quoted()) {
+                        error = string_functions::to_number(view(), value);
+                        return value;
+                    }
+                    std::array<char, 128> buffer;
+                    if (size() <= buffer.size()) {
+                        auto const n = string_functions::unescape({b, e}, Quote::value, buffer.data());
+                        error = string_functions::to_number(TrimPolicy::trimmed({buffer.data(), n}), value);
+                        return value;
+                    }
+                }
+                cell_string s;
+                read_value(s);
+                error = string_functions::to_number(s, value);
+                return value;
+            }
+
+            // Number of a field (see above). Throws an exception telling the field it fails to convert
+            template <NumberConcept T>
+            [[nodiscard]] auto as() const -> T {
+                std::errc error {};
+                auto const value = as<T>(error);
+                if (error != std::errc{}) {
+                    throw exception ("Field \"", std::string_view{b, e}, "\" is not a number: ",
+                                     std::make_error_code(error).message());
+                }
+                return value;
+            }
+
+            // Value of a field as a number or a string
+            template <typename T>
+            [[nodiscard]] auto read_value() const -> T {
+                T value;
+                read_value(value);
+                return value;
+            }
+
+            // Value of a field to a string (its capacity is reused), or to a number (see as())
+            void read_value(auto & s) const {
+                assert(b!=nullptr && e!=nullptr);
+                if constexpr (NumberConcept<std::remove_cvref_t<decltype(s)>>) {
+                    s = as<std::remove_cvref_t<decltype(s)>>();
                 } else {
-                    using namespace string_functions;
-                    bool was_devastated = devastated(field);
-                    if (!was_devastated) {
-                        // Extension: we allow partly double-quoted fields.
-                        // So we leave these double quotes.
-                        field += b;
-                    }
-                    unsigned quote_counter{1};
-                    for(;;) {
-                        b = co_await char{};
-                        if (limiter(b) && !(quote_counter & 1)) {
-                            if (was_devastated) {
-                                del_last(field, Quote::value);
-                            }
-                            unique_quote(field, Quote::value);
-                            finalize_field(field)
-                            break;
+                    if constexpr (trims_views) {
+                        // Nothing to unquote: the value is copied once (into the capacity of s), and not mangled
+                        if (!quoted()) {
+                            auto const value = view();
+                            s.assign(value.begin(), value.end());
+                            return;
                         }
-                        quote_counter += (Quote::value == b) ? 1 : 0;
-                        field += b;
                     }
+                    // Unquoted in the guaranteed sufficient space of the field
+                    s.resize(size());
+                    s.resize(string_functions::unescape({b, e}, Quote::value, s.data()));
+                    TrimPolicy::trim(s);
                 }
             }
-        }
+        };
 
-        // Coroutine that parses CSV-stream for spanning mode
-        auto parse_cell_span() const noexcept -> FSM_cell_span {
-            cell_span noopt_span;
+        // Block of rows in run_blocks(): fields of its rows by columns (structure of arrays), as offsets
+        // from data() and lengths of their chars in the source (quoted and untrimmed, as spans have them)
+        class row_block {
+        private:
+            typename cell_string::const_pointer base = nullptr;
+            std::size_t capacity;
+            std::size_t n_rows {0};
+            std::size_t n_cols;
+            // Column-major: fields of column c are at [c * capacity, c * capacity + n_rows)
+            std::vector<std::size_t> offs;
+            std::vector<std::size_t> lens;
+
+            friend reader;
+
+            row_block(std::size_t cols, std::size_t rows) : capacity(rows), n_cols(cols),
+                offs(cols * rows), lens(cols * rows) {}
+
+            void add_col() {
+                n_cols++;
+                offs.resize(n_cols * capacity);
+                lens.resize(n_cols * capacity);
+            }
+        public:
+            [[nodiscard]] auto rows() const noexcept -> std::size_t { return n_rows; }
+            [[nodiscard]] auto cols() const noexcept -> std::size_t { return n_cols; }
 
-            std::visit([&](auto&& arg) {
-                noopt_span.b = noopt_span.e = std::addressof(arg[0]);
-            }, src );
+            // Beginning of the block's chars, valid during the call of a callback only
+            [[nodiscard]] auto data() const noexcept -> typename cell_string::const_pointer { return base; }
 
-            for(;;) {
-                auto b = co_await char{};
-                noopt_span.e++;
-                if (limiter(b)) {
-                    co_yield noopt_span;
-                    noopt_span.b = noopt_span.e;
-                } else
-                if (Quote::value == b) {
-                    unsigned quote_counter {1};
-                    for(;;) {
-                        b = co_await char{};
-                        noopt_span.e++;
-                        if (limiter(b) && !(quote_counter & 1)) {
-                            co_yield noopt_span;
-                            noopt_span.b = noopt_span.e;
-                            break;
-                        }
-                        quote_counter += (Quote::value == b) ? 1 : 0;
+            // Offsets of fields of a column from data(), a row each
+            [[nodiscard]] auto offsets(std::size_t col) const noexcept -> std::span<std::size_t const> {
+                assert(col < n_cols);
+                return {offs.data() + col * capacity, n_rows};
+            }
+
+            // Lengths of fields of a column, a row each
+            [[nodiscard]] auto lengths(std::size_t col) const noexcept -> std::span<std::size_t const> {
+                assert(col < n_cols);
+                return {lens.data() + col * capacity, n_rows};
+            }
+
+            // Span of a field, to take its value
+            [[nodiscard]] auto field(std::size_t row, std::size_t col) const noexcept -> cell_span {
+                assert(row < n_rows && col < n_cols);
+                cell_span span;
+                span.b = base + offs[col * capacity + row];
+                span.e = span.b + lens[col * capacity + row];
+                return span;
+            }
+        };
+
+        // Row of records(): spans of its fields, valid until the next row is pulled
+        class record {
+        private:
+            std::span<cell_span const> fields;
+
+            friend reader;
+
+            explicit record(std::span<cell_span const> fields) noexcept : fields(fields) {}
+        public:
+            record() = default;
+
+            [[nodiscard]] auto size() const noexcept -> std::size_t { return fields.size(); }
+
+            [[nodiscard]] auto operator[](std::size_t i) const noexcept -> cell_span const & {
+                assert(i < fields.size());
+                return fields[i];
+            }
+
+            [[nodiscard]] auto begin() const noexcept { return fields.begin(); }
+            [[nodiscard]] auto end() const noexcept { return fields.end(); }
+        };
+
+        // Input range of records of a source, pulled one by one: the source is read as far as rows are pulled.
+        // Its coroutine frame is on the heap, and errors of reading are thrown by begin() and increments.
+        class record_range {
+        public:
+            struct promise_type {
+                record current;
+                std::exception_ptr error;
+
+                auto get_return_object() noexcept -> record_range {
+                    return record_range {std::coroutine_handle<promise_type>::from_promise(*this)};
+                }
+                std::suspend_always initial_suspend() noexcept { return {}; }
+                std::suspend_always final_suspend() noexcept { return {}; }
+                auto yield_value(record r) noexcept {
+                    current = r;
+                    return std::suspend_always{};
+                }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { error = std::current_exception(); }
+            };
+
+        private:
+            using handle_type = std::coroutine_handle<promise_type>;
+            handle_type handle {nullptr};
+            bool started {false};
+
+            explicit record_range(handle_type h) noexcept : handle(h) {}
+
+            static void resume(handle_type h) {
+                h.resume();
+                if (auto const error = std::exchange(h.promise().error, nullptr)) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+        public:
+            class iterator {
+                handle_type handle {nullptr};
+
+                friend record_range;
+
+                explicit iterator(handle_type h) noexcept : handle(h) {}
+            public:
+                using iterator_concept = std::input_iterator_tag;
+                using value_type = record;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+
+                auto operator*() const noexcept -> record const & { return handle.promise().current; }
+                auto operator++() -> iterator & {
+                    resume(handle);
+                    return *this;
+                }
+                void operator++(int) { ++*this; }
+
+                friend auto operator==(iterator const & i, std::default_sentinel_t) noexcept -> bool {
+                    return !i.handle || i.handle.done();
+                }
+            };
+
+            record_range(record_range const &) = delete;
+            record_range(record_range && other) noexcept : handle(std::exchange(other.handle, nullptr)),
+                started(other.started) {}
+            auto operator=(record_range && other) noexcept -> record_range & {
+                if (this != &other) {
+                    if (handle) {
+                        handle.destroy();
                     }
+                    handle = std::exchange(other.handle, nullptr);
+                    started = other.started;
                 }
+                return *this;
+            }
+            ~record_range() {
+                if (handle) {
+                    handle.destroy();
+                }
+            }
+
+            // Pulls the first row, once: an input range is walked once
+            auto begin() -> iterator {
+                if (handle && !std::exchange(started, true)) {
+                    resume(handle);
+                }
+                return iterator {handle};
+            }
+            auto end() const noexcept -> std::default_sentinel_t { return {}; }
+        };
+
+        static constexpr char LF{'\n'};
+
+        // Delimiters and LFs outside quoted areas of the chunks being sent to a state machine
+        using structural_index = simd::structural_index<Quote::value, Delimiter::value>;
+
+        // Ready value of a field: a view into the source if the field has no quotes (mostly), or into the buffer
+        // it is unquoted to. Extension: partly quoted fields keep their quotes, but an opening one.
+        static auto ready_value(cell_span const & span, cell_string & buffer) -> std::string_view {
+            if constexpr (cell_span::trims_views) {
+                if (!span.quoted()) {
+                    return span.view();
+                }
+            }
+            buffer.resize(span.size());
+            buffer.resize(string_functions::unescape({span.b, span.e}, Quote::value, buffer.data(), true));
+            if constexpr (cell_span::trims_views) {
+                return TrimPolicy::trimmed(buffer);
+            } else {
+                TrimPolicy::trim(buffer);
+                return buffer;
             }
         }
 
+        // Visits fields ending in an indexed chunk, the first one begins at b. Returns the beginning of the next one.
+        // (Being not a coroutine itself, it keeps the hot loop in registers rather than in a coroutine frame.)
+        static auto for_each_span(coroutine_stream_type chunk, structural_index const & index,
+                                  coroutine_stream_type::pointer b, auto && f) -> coroutine_stream_type::pointer {
+            cell_span span;
+            span.b = b;
+            for (std::size_t block = 0; block < index.size(); block++) {
+                for (auto limiters = index.limiters(block); limiters; limiters &= limiters - 1) {
+                    span.e = chunk.data() + block * simd::block_size + std::countr_zero(limiters);
+                    f(std::as_const(span));
+                    span.b = span.e + 1;
+                }
+            }
+            return span.b;
+        }
+
         // Coroutine that parses CSV-stream for columns counting
         auto parse_cols() const noexcept -> FSM_cols {
-            std::optional<std::size_t> cols = 0;
+            // Columns of every row completed within a chunk
+            std::vector<std::size_t> batch;
+            structural_index index {chunk_size};
+            std::size_t cols {0};
             for(;;) {
-                auto b = co_await char{};
-                if (limiter(b)) {
-                    cols = cols.value() + 1;
-                    if (LF == b) {
-                        co_yield cols;
+                auto const chunk = co_await coroutine_stream_type{};
+                batch.clear();
+                index.build(chunk);
+                for (std::size_t block = 0; block < index.size(); block++) {
+                    auto delimiters = index.delimiters(block);
+                    for (auto lfs = index.lfs(block); lfs; lfs &= lfs - 1) {
+                        auto const before_lf = (std::uint64_t{1} << std::countr_zero(lfs)) - 1;
+                        batch.push_back(cols + std::popcount(delimiters & before_lf) + 1);
+                        delimiters &= ~before_lf;
                         cols = 0;
                     }
-                } else
-                if (Quote::value == b) {
-                    unsigned quote_counter = 1;
-                    for(;;) {
-                        b = co_await char{};
-                        if (limiter(b) && !(quote_counter & 1)) {
-                            cols = cols.value() + 1;
-                            if (LF == b) {
-                                co_yield cols;
-                                cols = 0;
-                                break;
-                            }
-                        }
-                        quote_counter += (Quote::value == b) ? 1 : 0;
-                    }
+                    cols += std::popcount(delimiters);
                 }
+                co_yield batch;
             }
         }
 
         // Coroutine that parses CSV-stream for rows counting
         auto parse_rows() const noexcept -> FSM_rows {
-            std::optional<bool> line_end;
+            structural_index index {chunk_size};
             for (;;) {
-                auto b = co_await char{};
-                if (limiter(b)) {
-                    if (LF == b) {
-                        line_end = true;
-                        co_yield line_end;
-                    }
-                } else
-                if (Quote::value == b) {
-                    unsigned quote_counter = 1;
-                    for (;;) {
-                        b = co_await char{};
-                        if (limiter(b) && !(quote_counter & 1)) {
-                            if (LF == b) {
-                                line_end = true;
-                                co_yield line_end;
-                            }
-                            break;
-                        }
-                        quote_counter += (Quote::value == b) ? 1 : 0;
-                    }
+                auto const chunk = co_await coroutine_stream_type{};
+                std::size_t rows {0};
+                index.build(chunk);
+                for (std::size_t block = 0; block < index.size(); block++) {
+                    rows += std::popcount(index.lfs(block));
                 }
+                co_yield rows;
             }
         }
 
-        using coroutine_stream_type = mio::ro_mmap::value_type;
+        // Gives back chunks of a mapped file two chunks behind the one being sent: a field straddling chunks
+        // begins in the previous one mostly (and longer ones are just read in again)
+        template <typename Range>
+        static void drop_behind(Range const & r, std::size_t offset) noexcept {
+            if constexpr (std::is_same_v<Range, mio::ro_mmap>) {
+                if (offset >= 2 * chunk_size) {
+                    r.drop(r.data() + offset - 2 * chunk_size, r.data() + offset - chunk_size);
+                }
+            }
+        }
 
-        // Returns sending coroutine for Ready-value mode
+        // Returns sending coroutine for counting state machines (a last row lacking LF is sent one)
         template <typename Range>
         auto sender(Range const & r) const -> generator<coroutine_stream_type> {
-            for (auto e : r) {
-                co_yield e;
+            for (std::size_t offset = 0; offset < r.size(); offset += chunk_size) {
+                drop_behind(r, offset);
+                co_yield coroutine_stream_type {r.data() + offset, std::min(chunk_size, r.size() - offset)};
             }
 #if 0
             // TODO: after moving this is false:
@@ -478,39 +876,835 @@ namespace csv_co {
             if (!r.empty())
 #endif
                 if (LF != r.back()) {
-                    co_yield '\n';
+                    co_yield coroutine_stream_type {&LF, 1};
                 }
         }
 
-        // Returns sending coroutine for spanning mode
-        template <typename Range>
-        auto span_sender(Range const & r) const -> generator<coroutine_stream_type> {
-            for (auto e : r) {
-                co_yield e;
+        // Returns sending coroutine for counting state machines over a stream source, sent by chunks as taken
+        auto sender(stream_source const & s) const -> generator<coroutine_stream_type> {
+            auto last {LF};
+            for (auto taken = s.take(chunk_size); !taken.empty(); taken = s.take(chunk_size)) {
+                for (std::size_t offset = 0; offset < taken.size(); offset += chunk_size) {
+                    co_yield taken.subspan(offset, std::min(chunk_size, taken.size() - offset));
+                }
+                last = taken.back();
+            }
+            if (LF != last) {
+                co_yield coroutine_stream_type {&LF, 1};
             }
         }
 
-        // Returns coroutine sending the last LF
-        template <typename Range>
-        auto span_LF_sender(Range const &) const -> generator<coroutine_stream_type> {
-            co_yield '\n';
+        // Returns sending coroutine for counting state machines over a file mapped by windows, sent as they come
+        auto sender(mio::ro_mmap_windows const & w) const -> generator<coroutine_stream_type> {
+            auto last {LF};
+            for (std::size_t offset = 0; offset < w.size(); ) {
+                auto const window = w.window(offset, offset);
+                if (window.empty()) {
+                    break;
+                }
+                for (std::size_t chunk = 0; chunk < window.size(); chunk += chunk_size) {
+                    co_yield window.subspan(chunk, std::min(chunk_size, window.size() - chunk));
+                }
+                last = window.back();
+                offset += window.size();
+            }
+            if (LF != last) {
+                co_yield coroutine_stream_type {&LF, 1};
+            }
+        }
+
+        // Spanning mode reads sources by pieces. A consumer of pieces keeps `next` (the beginning of the field
+        // straddling them) up to date, and may pin a position behind it: chars from it on stay readable, at
+        // the position the pin is updated to (sources reusing their buffers and windows move them).
+        // Sources read to the end yield an empty piece at last, their chars being readable still.
+
+        // Returns sending coroutine of pieces of a source staying in place
+        template <bool OnHeap = false, typename Range>
+        auto pieces(Range const & r, coroutine_stream_type::pointer & next,
+                    coroutine_stream_type::pointer * pinned) const -> generator<coroutine_stream_type, OnHeap> {
+            next = r.data();
+            if (pinned) {
+                *pinned = r.data();
+            }
+            for (std::size_t offset = 0; offset < r.size(); offset += chunk_size) {
+                drop_behind(r, offset);
+                co_yield coroutine_stream_type {r.data() + offset, std::min(chunk_size, r.size() - offset)};
+            }
+            co_yield coroutine_stream_type {r.data() + r.size(), 0};
+        }
+
+        // Returns sending coroutine of pieces of a stream source. Chars taken from it (buffers read ahead, lent
+        // by the source) are sent in place. The field straddling them (or the pinned chars) is carried to a buffer
+        // of the coroutine, and the next chars taken are copied after it only as long as it goes on: so the
+        // buffer grows to fit the longest field (or pinned chars) only.
+        template <bool OnHeap = false>
+        auto pieces(stream_source const & s, coroutine_stream_type::pointer & next,
+                    coroutine_stream_type::pointer * pinned) const -> generator<coroutine_stream_type, OnHeap> {
+            std::vector<char> buf;
+            std::size_t carried {0};
+            std::size_t field {0}; // offset of the straddling field in the carried chars
+            for (auto taken = s.take(chunk_size); !taken.empty(); taken = s.take(chunk_size)) {
+                std::size_t sent {0};
+                // Carried chars are joined by the taken ones in the buffer, until the straddling field (or the pin)
+                // gets to the taken ones
+                while (carried && sent < taken.size()) {
+                    auto const n = std::min(chunk_size, taken.size() - sent);
+                    buf.resize(carried + n);
+                    std::copy(taken.data() + sent, taken.data() + sent + n, buf.data() + carried);
+                    next = buf.data() + field;
+                    if (pinned) {
+                        *pinned = buf.data();
+                    }
+                    co_yield coroutine_stream_type {buf.data() + carried, n};
+                    auto const joined = buf.data() + carried;
+                    auto const kept = pinned ? *pinned : next;
+                    if (kept >= joined) {
+                        // Taken chars are in place from the kept one
+                        next = taken.data() + sent + (next - joined);
+                        if (pinned) {
+                            *pinned = taken.data() + sent + (kept - joined);
+                        }
+                        carried = 0;
+                    } else {
+                        field = static_cast<std::size_t>(next - kept);
+                        carried = static_cast<std::size_t>(joined + n - kept);
+                        if (kept != buf.data()) {
+                            std::copy(kept, kept + carried, buf.data());
+                        }
+                    }
+                    sent += n;
+                }
+                if (!sent) {
+                    next = taken.data();
+                    if (pinned) {
+                        *pinned = taken.data();
+                    }
+                }
+                for (; sent < taken.size(); sent += chunk_size) {
+                    co_yield taken.subspan(sent, std::min(chunk_size, taken.size() - sent));
+                }
+                // Whatever is kept of the taken chars is carried, as the next take gives them back to the source
+                if (!carried) {
+                    auto const kept = pinned ? *pinned : next;
+                    auto const end = taken.data() + taken.size();
+                    field = static_cast<std::size_t>(next - kept);
+                    carried = static_cast<std::size_t>(end - kept);
+                    buf.assign(kept, end);
+                }
+            }
+            // Nothing carried still has an end: the closing piece has a position to give the last (empty) field
+            buf.reserve(carried + 1);
+            next = buf.data() + field;
+            if (pinned) {
+                *pinned = buf.data();
+            }
+            co_yield coroutine_stream_type {buf.data() + carried, 0};
+        }
+
+        // Returns sending coroutine of pieces of a file mapped by windows. A next window begins at the page of
+        // the field straddling the previous one (or of the pinned position), so fields stay in place: windows
+        // grow only to take fields (or pinned chars) longer than themselves.
+        template <bool OnHeap = false>
+        auto pieces(mio::ro_mmap_windows const & w, coroutine_stream_type::pointer & next,
+                    coroutine_stream_type::pointer * pinned) const -> generator<coroutine_stream_type, OnHeap> {
+            std::size_t first {0};
+            std::size_t field {0}; // offset of the straddling field in the next window
+            coroutine_stream_type window;
+            for (std::size_t from = 0; from < w.size(); ) {
+                window = w.window(first, from);
+                if (window.empty()) {
+                    co_return; // see check_read()
+                }
+                next = window.data() + field;
+                if (pinned) {
+                    *pinned = window.data();
+                }
+                for (auto offset = from - first; offset < window.size(); offset += chunk_size) {
+                    co_yield window.subspan(offset, std::min(chunk_size, window.size() - offset));
+                }
+                auto const kept = pinned ? *pinned : next;
+                field = static_cast<std::size_t>(next - kept);
+                from = first + window.size();
+                first += static_cast<std::size_t>(kept - window.data());
+            }
+            co_yield coroutine_stream_type {window.data() + window.size(), 0};
         }
 
-        // Function sending the last LF
-        void last_LF(const auto &arg, FSM_cell_span &p) const {
-            if (arg.back() != LF) {
-                p.send(*(span_LF_sender(arg).begin()));
-                if (const auto &r = p(); r()) {
-                    auto res = r;
-                    res.e--;
-                    vfcs_cb(res);
-                    new_row_cb(); // Unconditionally
+        template <typename T>
+        static constexpr bool streamed = std::is_same_v<std::remove_cvref_t<T>, stream_source>;
+        template <typename T>
+        static constexpr bool windowed = std::is_same_v<std::remove_cvref_t<T>, mio::ro_mmap_windows>;
+
+        // Callables doing nothing, as missing callbacks
+        static constexpr auto no_field = [](auto const &) noexcept {};
+        static constexpr auto no_row = []() noexcept {};
+
+        // Visits fields of a source in spanning mode: f(span) for fields ending with limiters, and last(span)
+        // for the last field of a source lacking the last LF. Reading ends after a piece where the flow stops.
+        // The pinned position (see pieces()) is the beginning of the source at first, moved on by f.
+        // end() is called at the end of a source read to the end, while its chars are readable still.
+        template <typename End = decltype(no_row)>
+        void for_each_source_span(auto const & arg, auto && f, auto && last, control const & flow = go_on,
+                                  coroutine_stream_type::pointer * pinned = nullptr, End && end = {}) const {
+            structural_index index {chunk_size};
+            coroutine_stream_type::pointer next {nullptr};
+            auto last_char {LF};
+            for (auto const & piece : pieces(arg, next, pinned)) {
+                if (piece.empty()) {
+                    // In spanning mode last LF (if not in source) - gives no chance to dereference the source.
+                    // Because dereference would come to non-existent position: the end().
+                    // So the end of source is reported separately. Otherwise, we would have to double-check for
+                    // every one field in the cycle above. (See revision history)
+                    if (LF != last_char && !index.quoted()) {
+                        cell_span span;
+                        span.b = next;
+                        span.e = piece.data();
+                        last(std::as_const(span));
+                    }
+                    end();
+                    return;
                 }
+                index.build(piece);
+                next = for_each_span(piece, index, next, f);
+                last_char = piece.back();
+                if (flow == control::stop) {
+                    return;
+                }
+            }
+        }
+
+        static constexpr control go_on {control::next};
+
+        // Calls a callback, taking its control of a run if it returns one
+        template <typename F, typename ... Args>
+        static auto controlled(F & f, Args const & ... args) -> control {
+            if constexpr (std::is_same_v<std::invoke_result_t<F &, Args const & ...>, control>) {
+                return f(args...);
+            } else {
+                f(args...);
+                return control::next;
+            }
+        }
+
+        // Reports a read error of a stream source, or a mapping error of a file mapped by windows
+        static void check_read(auto const & arg) {
+            if constexpr (streamed<decltype(arg)> || windowed<decltype(arg)>) {
+                if (auto const error = arg.error()) {
+                    throw exception (error.message());
+                }
+            }
+        }
+
+        // The whole source in memory: a mapped file or a string
+        auto whole_source() const -> coroutine_stream_type {
+            return std::visit([](auto&& arg) -> coroutine_stream_type {
+                if constexpr (streamed<decltype(arg)>) {
+                    throw exception ("Stream sources are only read once and in order");
+                } else if constexpr (windowed<decltype(arg)>) {
+                    throw exception ("Files mapped by windows are only read in order");
+                } else {
+                    return {arg.data(), arg.size()};
+                }
+            }, src);
+        }
+
+        // Ready-value mode over any callables (header fields - the whole first row): values of spans
+        template <bool WithHeader>
+        void run_values(auto & hfcb, auto & fcb, auto & nrc) const {
+            cell_string buffer;
+            auto header_value = [&](cell_span const & span) { return controlled(hfcb, ready_value(span, buffer)); };
+            auto value = [&](cell_span const & span) { return controlled(fcb, ready_value(span, buffer)); };
+            run_spans<WithHeader>(header_value, value, nrc);
+        }
+
+        // Spanning mode over any callables (header fields - the whole first row)
+        template <bool WithHeader>
+        void run_spans(auto & hfcb, auto & fcb, auto & nrc) const {
+            std::visit([&](auto&& arg) {
+                std::size_t rows {0};
+                std::size_t fields {0}; // of the first row
+                auto header {WithHeader};
+                auto flow {control::next};
+                auto row_end = [&] {
+                    if (!rows) {
+                        cols_memo.set(fields);
+                    }
+                    header = false;
+                    flow = controlled(nrc) == control::stop ? control::stop : control::next;
+                    rows++;
+                };
+                for_each_source_span(arg, [&](cell_span const & span) {
+                    fields += !rows;
+                    if (flow == control::next) {
+                        flow = (WithHeader && header) ? controlled(hfcb, span) : controlled(fcb, span);
+                    }
+                    if (*span.e == LF && flow != control::stop) {
+                        row_end();
+                    }
+                }, [&](cell_span const & span) {
+                    fields += !rows;
+                    if (flow == control::next) {
+                        flow = (WithHeader && header) ? controlled(hfcb, span) : controlled(fcb, span);
+                    }
+                    if (flow != control::stop) {
+                        row_end(); // Unconditionally
+                    }
+                }, flow);
+                check_read(arg);
+                // Rows of a run stopped are not all of them
+                if (flow != control::stop) {
+                    rows_memo.set(rows);
+                }
+            }, src);
+        }
+
+        // Coroutine pulling records of a source: rows completed in a piece are yielded once it is visited.
+        // Their fields are kept by offsets from the beginning of the first row not yielded yet, which is pinned.
+        // Pieces are sent by a coroutine of a frame on the heap, as the range may be destroyed by any thread.
+        auto pull_records(auto const & arg) const -> record_range {
+            structural_index index {chunk_size};
+            std::vector<std::pair<std::size_t, std::size_t>> at;
+            std::vector<std::size_t> row_ends; // numbers of fields in `at` after rows' ends
+            std::vector<cell_span> fields;
+            coroutine_stream_type::pointer next {nullptr};
+            coroutine_stream_type::pointer pin {nullptr};
+            std::size_t rows {0};
+            auto last_char {LF};
+            auto const offset = [&pin](coroutine_stream_type::pointer p) { return static_cast<std::size_t>(p - pin); };
+            for (auto const & piece : pieces<true>(arg, next, &pin)) {
+                if (!piece.empty()) {
+                    index.build(piece);
+                    next = for_each_span(piece, index, next, [&](cell_span const & span) {
+                        at.emplace_back(offset(span.b), offset(span.e));
+                        if (*span.e == LF) {
+                            row_ends.push_back(at.size());
+                        }
+                    });
+                    last_char = piece.back();
+                } else if (LF != last_char && !index.quoted()) {
+                    at.emplace_back(offset(next), offset(piece.data()));
+                    row_ends.push_back(at.size());
+                }
+                std::size_t first {0};
+                for (auto const row_end : row_ends) {
+                    fields.resize(row_end - first);
+                    for (std::size_t i = 0; i < fields.size(); i++) {
+                        fields[i].b = pin + at[first + i].first;
+                        fields[i].e = pin + at[first + i].second;
+                    }
+                    if (!rows) {
+                        cols_memo.set(fields.size());
+                    }
+                    rows++;
+                    co_yield record {fields};
+                    first = row_end;
+                }
+                if (first) {
+                    // The pin goes on to the row not completed yet
+                    auto const moved = at[first - 1].second + 1;
+                    at.erase(at.begin(), at.begin() + static_cast<std::ptrdiff_t>(first));
+                    for (auto & [b, e] : at) {
+                        b -= moved;
+                        e -= moved;
+                    }
+                    pin += moved;
+                    row_ends.clear();
+                }
+                if (piece.empty()) {
+                    break;
+                }
+            }
+            check_read(arg);
+            rows_memo.set(rows);
+        }
+
+        // Runs over selected columns only (header fields - the whole first row, which names select columns from)
+        template <bool Values, bool WithHeader>
+        void run_selected(columns const & selected, auto & hfcb, auto & fcb, auto & nrc) const {
+            auto wanted = selected.mask();
+            auto naming = selected.by_names();
+            std::vector<bool> named (naming ? selected.size() : 0);
+            std::size_t col {0};
+            cell_string buffer;
+            auto deliver = [&](auto & cb, cell_span const & span) {
+                auto const selected_col = col < wanted.size() && wanted[col];
+                col++;
+                if (!selected_col) {
+                    return control::next;
+                }
+                if constexpr (Values) {
+                    return controlled(cb, ready_value(span, buffer));
+                } else {
+                    return controlled(cb, span);
+                }
+            };
+            auto header_field = [&](cell_span const & span) {
+                if (naming) {
+                    if (auto const n = selected.named(ready_value(span, buffer))) {
+                        wanted.resize(std::max(wanted.size(), col + 1));
+                        wanted[col] = named[*n] = true;
+                    }
+                }
+                return deliver(hfcb, span);
+            };
+            auto field = [&](cell_span const & span) {
+                return deliver(fcb, span);
+            };
+            auto row = [&] {
+                if (std::exchange(naming, false)) {
+                    if (auto const missing = std::ranges::find(named, false); missing != named.end()) {
+                        throw exception ("No column named ", selected.name(static_cast<std::size_t>(missing - named.begin())));
+                    }
+                }
+                col = 0;
+                return controlled(nrc);
+            };
+            if (WithHeader || naming) {
+                run_spans<true>(header_field, field, row);
+            } else {
+                run_spans<false>(header_field, field, row);
             }
         }
 
+        // Row mode over any callables (header row - the first one): spans of all fields of a row at once.
+        // They are kept in an array of cols() spans reused by all rows (the first row may only grow it).
+        // Rows having more fields throw at their ends: a tail inside unclosed quotes never ends, and is dropped.
+        template <bool WithHeader>
+        void run_rows_of(auto & hrcb, auto & rcb) const {
+            std::visit([&](auto&& arg) {
+                std::vector<cell_span> fields (cols());
+                // Fields are recorded by offsets from the row's beginning: sources may move it between chunks
+                std::vector<std::pair<std::size_t, std::size_t>> at (fields.size());
+                coroutine_stream_type::pointer row {nullptr};
+                std::size_t n {0};
+                std::size_t width {0}; // fields of the first row
+                std::size_t rows {0};
+                auto flow {control::next};
+                auto record = [&](cell_span const & span) {
+                    if (n == fields.size()) {
+                        fields.emplace_back();
+                        at.emplace_back();
+                    }
+                    at[n++] = {static_cast<std::size_t>(span.b - row), static_cast<std::size_t>(span.e - row)};
+                };
+                auto row_end = [&] {
+                    if (!rows) {
+                        width = n;
+                    } else if (n > width) {
+                        throw exception ("Incorrect CSV source format: row ", rows, " has more fields than ", width);
+                    }
+                    for (std::size_t i = 0; i < n; i++) {
+                        fields[i].b = row + at[i].first;
+                        fields[i].e = row + at[i].second;
+                    }
+                    std::span<cell_span const> const spans {fields.data(), n};
+                    auto const c = (WithHeader && !rows) ? controlled(hrcb, spans) : controlled(rcb, spans);
+                    flow = c == control::stop ? control::stop : control::next;
+                    if (!rows) {
+                        cols_memo.set(n);
+                    }
+                    n = 0;
+                    rows++;
+                };
+                for_each_source_span(arg, [&](cell_span const & span) {
+                    if (flow == control::stop) {
+                        return;
+                    }
+                    record(span);
+                    if (*span.e == LF) {
+                        row_end();
+                        row = span.e + 1;
+                    }
+                }, [&](cell_span const & span) {
+                    if (flow != control::stop) {
+                        record(span);
+                        row_end();
+                    }
+                }, flow, &row);
+                check_read(arg);
+                if (flow != control::stop) {
+                    rows_memo.set(rows);
+                }
+            }, src);
+        }
+
+        // Block mode over any callables (header row - a block of its own): rows by blocks of some rows at most.
+        // Blocks keep their chars readable: the beginning of a block is pinned in sources moving their chars.
+        template <bool WithHeader>
+        void run_blocks_of(std::size_t size, auto & hbcb, auto & bcb) const {
+            if (!size) {
+                throw exception ("Blocks of no rows");
+            }
+            std::visit([&](auto&& arg) {
+                row_block block (cols(), size);
+                coroutine_stream_type::pointer pin {nullptr};
+                std::size_t col {0};
+                std::size_t rows {0};
+                auto flow {control::next};
+                auto deliver = [&](auto & cb) {
+                    block.base = pin;
+                    flow = controlled(cb, std::as_const(block)) == control::stop ? control::stop : control::next;
+                    block.n_rows = 0;
+                };
+                auto record = [&](cell_span const & span) {
+                    if (col >= block.n_cols) {
+                        if (rows) {
+                            col++; // excess fields throw at the row's end: a tail inside unclosed quotes never ends
+                            return;
+                        }
+                        block.add_col();
+                    }
+                    auto const at = col++ * block.capacity + block.n_rows;
+                    block.offs[at] = static_cast<std::size_t>(span.b - pin);
+                    block.lens[at] = span.size();
+                };
+                auto row_end = [&] {
+                    if (col != block.n_cols) {
+                        throw exception ("Incorrect CSV source format: row ", rows, " has ", col, " fields of ", block.n_cols);
+                    }
+                    if (!rows) {
+                        cols_memo.set(col);
+                    }
+                    col = 0;
+                    block.n_rows++;
+                    if (++rows == 1 && WithHeader) {
+                        deliver(hbcb);
+                    } else if (block.n_rows == size) {
+                        deliver(bcb);
+                    }
+                };
+                for_each_source_span(arg, [&](cell_span const & span) {
+                    if (flow == control::stop) {
+                        return;
+                    }
+                    record(span);
+                    if (*span.e == LF) {
+                        row_end();
+                        if (!block.n_rows) {
+                            pin = span.e + 1;
+                        }
+                    }
+                }, [&](cell_span const & span) {
+                    if (flow != control::stop) {
+                        record(span);
+                        row_end();
+                    }
+                }, flow, &pin, [&] {
+                    if (block.n_rows && flow != control::stop) {
+                        deliver(bcb);
+                    }
+                });
+                check_read(arg);
+                if (flow != control::stop) {
+                    rows_memo.set(rows);
+                }
+            }, src);
+        }
+
+        // Walks fields of whole rows of a part of a source by itself (not sharing coroutine frames with other threads)
+        void walk_span(coroutine_stream_type part, std::size_t id, std::size_t header_fields,
+                       header_field_span_cb_t const & hfcb, value_field_span_par_cb_t const & fcb,
+                       new_row_par_cb_t const & nrc) const {
+            structural_index index {chunk_size};
+            cell_span span;
+            span.b = part.data();
+            for (std::size_t offset = 0; offset < part.size(); offset += chunk_size) {
+                auto const piece = part.subspan(offset, std::min(chunk_size, part.size() - offset));
+                index.build(piece);
+                span.b = for_each_span(piece, index, span.b, [&](cell_span const & field) {
+                    header_fields ? (header_fields--, hfcb(field)) : fcb(field, id);
+                    if (LF == *field.e) {
+                        nrc(id);
+                    }
+                });
+            }
+            // Only the last part may end with a row lacking LF
+            if (!part.empty() && LF != part.back() && !index.quoted()) {
+                span.e = part.data() + part.size();
+                fcb(span, id);
+                nrc(id);
+            }
+        }
+
+        // Runs f(0) ... f(n-1) on their own threads and rethrows the first exception among them
+        static void in_parallel(std::size_t n, auto const & f) {
+            std::vector<std::exception_ptr> errors (n);
+            std::vector<std::thread> workers;
+            workers.reserve(n);
+            auto join = [&workers] {
+                for (auto & w : workers) {
+                    w.join();
+                }
+            };
+            try {
+                for (std::size_t i = 0; i < n; i++) {
+                    workers.emplace_back([&f, &errors, i] {
+                        try {
+                            f(i);
+                        } catch (...) {
+                            errors[i] = std::current_exception();
+                        }
+                    });
+                }
+            } catch (...) {
+                join();
+                throw;
+            }
+            join();
+            for (auto const & e : errors) {
+                if (e) {
+                    std::rethrow_exception(e);
+                }
+            }
+        }
+
+        // Splits a source into parts of whole rows, one per thread (0 - as many as the hardware runs concurrently):
+        // 1. Every part is speculated on both in-quote and out-of-quote start states (concurrently).
+        // 2. Parities of the parts' quotes fix the actual start states, and so the first row of every part.
+        // Parts lacking row starts are left empty, their rows belong to the preceding part.
+        static auto split(coroutine_stream_type whole, std::size_t threads) -> std::vector<coroutine_stream_type> {
+            if (!threads) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            auto const parts = std::min(threads, std::max<std::size_t>(1, whole.size() / chunk_size));
+
+            // Parts begin a char before their shares, so that a row starting right at a share is not missed
+            std::vector<std::size_t> bounds (parts + 1);
+            for (std::size_t i = 1; i < parts; i++) {
+                bounds[i] = whole.size() * i / parts - 1;
+            }
+            bounds[parts] = whole.size();
+
+            std::vector<simd::speculation> guesses (parts);
+            in_parallel(parts, [&](std::size_t i) {
+                guesses[i] = simd::speculate<Quote::value, Delimiter::value>(
+                        whole.subspan(bounds[i], bounds[i + 1] - bounds[i]), chunk_size);
+            });
+
+            constexpr auto none = simd::speculation::none;
+            std::vector<std::size_t> starts (parts, none);
+            starts[0] = 0;
+            bool odd_quotes = guesses[0].odd_quotes;
+            for (std::size_t i = 1; i < parts; i++) {
+                if (auto const lf = guesses[i].first_lf[odd_quotes]; lf != none) {
+                    starts[i] = bounds[i] + lf + 1;
+                }
+                odd_quotes ^= guesses[i].odd_quotes;
+            }
+            std::vector<coroutine_stream_type> ranges (parts);
+            for (auto i = parts, end = whole.size(); i--; ) {
+                if (starts[i] != none) {
+                    ranges[i] = whole.subspan(starts[i], end - starts[i]);
+                    end = starts[i];
+                }
+            }
+            return ranges;
+        }
+
+        // Parses parts of whole rows of a source concurrently
+        void span_parallel(std::size_t threads, std::size_t header_fields, header_field_span_cb_t const & hfcb,
+                           value_field_span_par_cb_t const & fcb, new_row_par_cb_t const & nrc) const {
+            auto const whole = whole_source();
+            if (whole.empty()) {
+                return;
+            }
+            auto const ranges = split(whole, threads);
+            in_parallel(ranges.size(), [&](std::size_t i) {
+                walk_span(ranges[i], i, i ? 0 : header_fields, hfcb, fcb, nrc);
+            });
+        }
+
+        // Offsets (within the whole source) of rows following LFs of a part. Quoted: the part ends inside quotes
+        static auto row_starts(coroutine_stream_type whole, coroutine_stream_type part, bool & quoted) -> std::vector<std::size_t> {
+            std::vector<std::size_t> starts;
+            structural_index index {chunk_size};
+            for (std::size_t offset = 0; offset < part.size(); offset += chunk_size) {
+                auto const piece = part.subspan(offset, std::min(chunk_size, part.size() - offset));
+                auto const base = static_cast<std::size_t>(piece.data() - whole.data());
+                index.build(piece);
+                for (std::size_t block = 0; block < index.size(); block++) {
+                    for (auto lfs = index.lfs(block); lfs; lfs &= lfs - 1) {
+                        starts.push_back(base + block * simd::block_size + std::countr_zero(lfs) + 1);
+                    }
+                }
+            }
+            quoted = index.quoted();
+            return starts;
+        }
+
+        // Key of a sidecar file of the index of rows: a format tag, its CSV file's size and modification time,
+        // and special chars of the reader. Empty if the CSV file is not there.
+        static auto index_key(std::filesystem::path const & csv_src) noexcept -> std::optional<std::array<std::uint64_t, 4>> {
+            std::error_code error;
+            auto const size = std::filesystem::file_size(csv_src, error);
+            if (error) {
+                return std::nullopt;
+            }
+            auto const time = std::filesystem::last_write_time(csv_src, error);
+            if (error) {
+                return std::nullopt;
+            }
+            return std::array<std::uint64_t, 4> {index_tag, size, static_cast<std::uint64_t>(time.time_since_epoch().count()),
+                    static_cast<unsigned char>(Quote::value) | static_cast<unsigned>(static_cast<unsigned char>(Delimiter::value)) << 8};
+        }
+        static constexpr std::uint64_t index_tag {0x3178'6469'6f63'7663}; // "cvcoidx1"
+
+        // Takes the index of rows from the sidecar file of a CSV file, if it is there and matches the file
+        void load_index(std::filesystem::path const & csv_src) {
+            auto const key = index_key(csv_src);
+            auto const sidecar = index_path(csv_src);
+            std::error_code error;
+            auto const sidecar_size = std::filesystem::file_size(sidecar, error);
+            std::ifstream in (sidecar, std::ios::binary);
+            if (!key || error || !in) {
+                return;
+            }
+            std::array<std::uint64_t, 4> sidecar_key {};
+            std::uint64_t offsets {0};
+            in.read(reinterpret_cast<char *>(sidecar_key.data()), sizeof(sidecar_key));
+            in.read(reinterpret_cast<char *>(&offsets), sizeof(offsets));
+            // the offsets are all in the sidecar, and a row takes a char at least
+            constexpr auto header = sizeof(sidecar_key) + sizeof(offsets);
+            if (!in || sidecar_key != *key || !offsets || offsets > (sidecar_size - header) / sizeof(std::uint64_t)
+                || offsets > (*key)[1] + 1) {
+                return;
+            }
+            std::vector<std::uint64_t> index (offsets);
+            in.read(reinterpret_cast<char *>(index.data()), static_cast<std::streamsize>(offsets * sizeof(std::uint64_t)));
+            if (!in || index.front() != 0 || !std::ranges::is_sorted(index) || !index_ends(index.back())) {
+                return;
+            }
+            row_index.assign(index.begin(), index.end());
+            rows_memo.set(row_index.size() - 1);
+        }
+
+        // Whether an index of rows may end at an offset, as index_rows() ends it: at the end of the source, or at
+        // the beginning of a tail inside unclosed quotes (an odd number of quotes from a row's beginning)
+        [[nodiscard]] auto index_ends(std::uint64_t last) const -> bool {
+            auto const whole = whole_source();
+            if (last >= whole.size()) {
+                return last == whole.size();
+            }
+            if (last && whole[last - 1] != LF) {
+                return false;
+            }
+            return std::ranges::count(whole.subspan(last), Quote::value) % 2 != 0;
+        }
+
+        // Offset of a row (or of the end of the source for i == rows) from the index, building it if there is none
+        auto indexed_row(std::size_t i) const -> std::size_t {
+            if (row_index.empty()) {
+                index_rows();
+            }
+            if (i >= row_index.size()) {
+                throw exception ("Row index out of range: ", i);
+            }
+            return row_index[i];
+        }
+
+        // Checks columns of every row against the first one's, while fields are being delivered
+        struct shape_checker {
+            std::size_t cols {0};
+            std::size_t fields {0};
+            std::size_t rows {0};
+
+            // Throws before a field exceeding the first row's columns is delivered
+            void field() {
+                if (++fields > cols && rows) {
+                    throw exception ("Incorrect CSV source format at row ", rows + 1);
+                }
+            }
+
+            void row_end() {
+                if (!rows) {
+                    cols = fields;
+                } else
+                if (fields != cols) {
+                    throw exception ("Incorrect CSV source format at row ", rows + 1);
+                }
+                rows++;
+                fields = 0;
+            }
+
+            // No rows are rows of an empty stream source only
+            [[nodiscard]] auto checked_rows(bool empty_source) const -> std::size_t {
+                if (!rows && !empty_source) {
+                    throw exception ("Use of Move-From state object");
+                }
+                return rows;
+            }
+        };
+
+        // Spanning mode checking the source's validity on the fly (header fields - the whole first row)
+        auto run_span_checked(bool with_header, auto const & hfcb, auto const & fcb) const -> std::size_t {
+            shape_checker shape;
+            auto deliver = [&](cell_span const & span, bool row_end) {
+                shape.field();
+                (with_header && !shape.rows) ? hfcb(span) : fcb(span);
+                if (row_end) {
+                    shape.row_end();
+                    new_row_cb();
+                }
+            };
+            auto empty_source {false};
+            std::visit([&](auto&& arg) {
+                for_each_source_span(arg, [&](cell_span const & span) {
+                    deliver(span, *span.e == LF);
+                }, [&](cell_span const & span) {
+                    deliver(span, true);
+                });
+                check_read(arg);
+                if constexpr (streamed<decltype(arg)>) {
+                    empty_source = !arg.moved_from();
+                }
+            }, src);
+            return memo_dimensions(shape.cols, shape.checked_rows(empty_source));
+        }
+
+        // Ready-value mode checking the source's validity on the fly: values of spans
+        auto run_checked(bool with_header) const -> std::size_t {
+            cell_string buffer;
+            return run_span_checked(with_header, [&](cell_span const & span) { hf_cb(ready_value(span, buffer)); },
+                                    [&](cell_span const & span) { vf_cb(ready_value(span, buffer)); });
+        }
+
+        // Remembers dimensions found by a full pass. Returns rows
+        auto memo_dimensions(std::size_t cols, std::size_t rows) const noexcept -> std::size_t {
+            cols_memo.set(cols);
+            rows_memo.set(rows);
+            return rows;
+        }
+
+        // Dimension of a source computed once, forgotten by a moved-from reader
+        class dimension {
+            std::optional<std::size_t> value;
+        public:
+            dimension() = default;
+            dimension(dimension && other) noexcept : value(std::exchange(other.value, std::nullopt)) {}
+            auto operator=(dimension && other) noexcept -> dimension & {
+                value = std::exchange(other.value, std::nullopt);
+                return *this;
+            }
+
+            template <typename F>
+            auto get(F && compute) noexcept -> std::size_t {
+                if (!value) {
+                    value = compute();
+                }
+                return *value;
+            }
+
+            void set(std::size_t v) noexcept {
+                value = v;
+            }
+
+            [[nodiscard]] auto value_or(std::size_t v) const noexcept -> std::size_t {
+                return value.value_or(v);
+            }
+        };
+
         // Multi-source CVS
-        std::variant<mio::ro_mmap, cell_string> src;
+        std::variant<mio::ro_mmap, cell_string, stream_source, mio::ro_mmap_windows> src;
 
         // nullptr by default, or user-defined by run(). UB if nullptr
         mutable header_field_cb_t hf_cb;
@@ -524,15 +1718,49 @@ namespace csv_co {
         // always user-defined: by run_span() or UB if user-defined nullptr
         mutable value_field_span_cb_t  vfcs_cb;
 
+        // computed by cols()/rows(), valid() or any full run
+        mutable dimension cols_memo;
+        mutable dimension rows_memo;
+
+        // Offsets of rows' beginnings, followed by the source's size. Built by index_rows() or loaded from a sidecar file
+        mutable std::vector<std::size_t> row_index;
+
+        // Empty but for CSV files
+        std::filesystem::path src_path;
+
     public:
         using trim_policy_type = TrimPolicy;
         using quote_type = Quote;
         using delimiter_type = Delimiter;
 
         // TODO: stop calling for rvalue string...
-        explicit reader(std::filesystem::path const & csv_src) : src {mio::ro_mmap {}} {
+        // Hints tell the kernel how the file is going to be read, e.g. {.sequential = true, .drop_consumed = true}
+        // for a single pass keeping the resident set small (consumed chunks are dropped by sequential runs only).
+        // Compressed files (gzip, zstd - told by their magic bytes) are decompressed as stream sources are read.
+        explicit reader(std::filesystem::path const & csv_src, mio::access_hints hints = {})
+                : src {mio::ro_mmap {}}, src_path {csv_src} {
+            if (auto const format = compression_of(csv_src); format != compression::none) {
+                if (!decompressed_file::supported(format)) {
+                    throw exception ("Decompression is not built in (CSV_CO_ZLIB, CSV_CO_ZSTD) : ", csv_src.string());
+                }
+                src = stream_source {csv_src, decompress {}};
+                src_path.clear();
+                return;
+            }
+            std::error_code mmap_error;
+            std::get<0>(src).map(csv_src.string().c_str(), mmap_error, hints);
+            if (mmap_error) {
+                throw exception (mmap_error.message(), " : ", csv_src.string());
+            }
+            load_index(csv_src);
+        }
+
+        // A file mapped by windows of a size, one at a time (and read in order only): for files larger than the
+        // address space or the memory allowed. Fields longer than a window make it grow.
+        reader(std::filesystem::path const & csv_src, mio::sliding_window window, mio::access_hints hints = {})
+                : src {mio::ro_mmap_windows {}} {
             std::error_code mmap_error;
-            std::get<0>(src).map(csv_src.string().c_str(), mmap_error);
+            std::get<3>(src).open(csv_src.string().c_str(), window, mmap_error, hints);
             if (mmap_error) {
                 throw exception (mmap_error.message(), " : ", csv_src.string());
             }
@@ -548,58 +1776,72 @@ namespace csv_co {
         // let us express C-style string parameter constructor via usual string parameter constructor
         explicit reader (const char * csv_src) : reader(cell_string(csv_src)) {}
 
+        // Stream sources are read once, in order and by chunks: memory stays the same whatever their size
+        explicit reader (stream_source csv_src) noexcept : src {std::move(csv_src)} {}
+        explicit reader (std::istream & csv_src) noexcept : reader(stream_source {csv_src}) {}
+
         // Move operations work by default - see tests
         reader (reader && other) noexcept = default;
         auto operator=(reader && other) noexcept -> reader & = default;
 
-        // Columns getter
+        // Columns getter (memoized). Stream sources have columns known after a run passing their first row only, 0 before
         [[nodiscard]] auto cols() const noexcept -> std::size_t {
-            auto result {0};
-            std::visit([this, &result](auto&& arg) noexcept {
-                auto source = sender(arg);
-                auto p = parse_cols();
-                for(const auto& b : source) {
-                    p.send(b);
-                    if (const auto& res = p(); res.has_value()) {
-                        result = res.value();
-                        return;
+            if (std::holds_alternative<stream_source>(src)) {
+                return cols_memo.value_or(0);
+            }
+            return cols_memo.get([this] {
+                std::size_t result {0};
+                std::visit([this, &result](auto&& arg) noexcept {
+                    auto p = parse_cols();
+                    for(auto const & chunk : sender(arg)) {
+                        p.send(chunk);
+                        if (auto const res = p(); !res.empty()) {
+                            result = res.front();
+                            return;
+                        }
                     }
-                }
-            }, src);
-            return result;
+                }, src);
+                return result;
+            });
         }
 
-        // Rows getter
+        // Rows getter (memoized). Stream sources have rows known after a run not stopped only, 0 before
         [[nodiscard]] auto rows() const noexcept -> std::size_t {
-            auto rows {0};
-            std::visit([&](auto&& arg) noexcept {
-                auto source = sender(arg);
-                auto p = parse_rows();
-                for(const auto& b : source) {
-                    p.send(b);
-                    if (const auto& res = p(); res.has_value()) {
-                        rows++;
+            if (std::holds_alternative<stream_source>(src)) {
+                return rows_memo.value_or(0);
+            }
+            return rows_memo.get([this] {
+                std::size_t rows {0};
+                std::visit([&](auto&& arg) noexcept {
+                    auto p = parse_rows();
+                    for(auto const & chunk : sender(arg)) {
+                        p.send(chunk);
+                        rows += p();
                     }
-                }
-            }, src);
-            return rows;
+                }, src);
+                return rows;
+            });
         }
 
-        // CSV-stream validator
+        // CSV-stream validator. Stream sources are validated while being run by run_valid()/run_span_valid()
         [[nodiscard]] auto valid() -> reader& {
+            if (std::holds_alternative<stream_source>(src)) {
+                throw exception ("Stream sources are only read once: use run_valid() or run_span_valid()");
+            }
             std::visit([&](auto&& arg) {
                 auto result {false};
                 std::optional<std::size_t> curr_cols;
-                auto source = sender(arg);
+                std::size_t rows {0};
                 auto p = parse_cols();
-                for(const auto& b : source) {
-                    p.send(b);
-                    if (const auto& res = p(); res.has_value()) {
+                for(auto const & chunk : sender(arg)) {
+                    p.send(chunk);
+                    for (auto const cols : p()) {
+                        rows++;
                         if (curr_cols == std::nullopt) {
-                            curr_cols = res.value();
+                            curr_cols = cols;
                             result = true; // if no more lines but this - stay valid!
                         } else {
-                            if (!(result = (curr_cols.value() == res.value()))) { //TODO: One of Clion static analyzers
+                            if (!(result = (curr_cols.value() == cols))) { //TODO: One of Clion static analyzers
                                 throw exception ("Incorrect CSV source format");
                             }
                         }
@@ -608,6 +1850,7 @@ namespace csv_co {
                 if (!result) {
                     throw exception ("Use of Move-From state object");
                 }
+                memo_dimensions(curr_cols.value(), rows);
             }, src);
 
             return *this;
@@ -615,107 +1858,241 @@ namespace csv_co {
 
         // Executes Ready-value mode
         void run(value_field_cb_t fcb, new_row_cb_t nrc=[]{}) const {
-            vf_cb = std::move(fcb);
-            new_row_cb = std::move(nrc);
-            std::visit([&](auto&& arg) {
-                auto source = sender(arg);
-                auto p = parse();
-                for (const auto &b: source) {
-                    p.send(b);
-                    if (const auto &res = p(); !res.empty()) {
-                        vf_cb(std::string_view{res.begin(),res.end()-1});
-                        if (LF == res.back()) {
-                            new_row_cb();
-                        }
-                    }
-                }
-            }, src);
+            run_values<false>(no_field, fcb, nrc);
         }
 
         // Executes Spanning mode
         void run_span(value_field_span_cb_t fcb, new_row_cb_t nrc= [] {}) const {
-            vfcs_cb = std::move(fcb);
-            new_row_cb = std::move(nrc);
-            std::visit([this](auto&& arg) noexcept {
-                auto const range_end = std::addressof(arg[arg.size()]);
-                auto source = span_sender(arg);
-                auto p = parse_cell_span();
-                for (auto const & b: source) {
-                    p.send(b);
-                    if (const auto & r = p(); r()) {
-                        auto res = r;
-                        res.e--;
-                        vfcs_cb(res);
-                        if (*res.e == LF) {
-                            new_row_cb();
-                        }
-                    }
-                }
+            run_spans<false>(no_field, fcb, nrc);
+        }
 
-                // In spanning mode last LF (if not in source) - gives no chance to dereference the source.
-                // Because dereference would come to non-existent position: the end().
-                // So we have to go for the trick. Otherwise, we would have to double-check for
-                // every one field in the cycle above. (See revision history)
+        // Executes Ready-value mode (overload)
+        void run(header_field_cb_t hfcb, value_field_cb_t fcb, new_row_cb_t nrc=[]{}) const {
+            run_values<true>(hfcb, fcb, nrc);
+        }
 
-                last_LF(arg, p);
-            }, src);
+        // Executes Spanning mode (overload)
+        void run_span(header_field_span_cb_t hfcb, value_field_span_cb_t fcb, new_row_cb_t nrc= [] {}) const {
+            run_spans<true>(hfcb, fcb, nrc);
         }
 
+        // Overloads taking any callables instead of std::function, so that calls of them can be inlined
+
         // Executes Ready-value mode (overload)
-        void run(header_field_cb_t hfcb, value_field_cb_t fcb, new_row_cb_t nrc=[]{}) const {
+        template <std::invocable<std::string_view> F, std::invocable R = decltype(no_row)>
+        void run(F && fcb, R && nrc = {}) const {
+            run_values<false>(no_field, fcb, nrc);
+        }
+
+        // Executes Ready-value mode (overload)
+        template <std::invocable<std::string_view> H, std::invocable<std::string_view> F, std::invocable R = decltype(no_row)>
+        void run(H && hfcb, F && fcb, R && nrc = {}) const {
+            run_values<true>(hfcb, fcb, nrc);
+        }
+
+        // Executes Spanning mode (overload)
+        template <std::invocable<cell_span const &> F, std::invocable R = decltype(no_row)>
+        void run_span(F && fcb, R && nrc = {}) const {
+            run_spans<false>(no_field, fcb, nrc);
+        }
+
+        // Executes Spanning mode (overload)
+        template <std::invocable<cell_span const &> H, std::invocable<cell_span const &> F, std::invocable R = decltype(no_row)>
+        void run_span(H && hfcb, F && fcb, R && nrc = {}) const {
+            run_spans<true>(hfcb, fcb, nrc);
+        }
+
+        // Executes Ready-value mode over selected columns only: their fields are delivered in order of rows.
+        // Selection by names makes the first row a header, as the overloads taking header callbacks do.
+        template <std::invocable<std::string_view> F, std::invocable R = decltype(no_row)>
+        void run(columns const & selected, F && fcb, R && nrc = {}) const {
+            run_selected<true, false>(selected, no_field, fcb, nrc);
+        }
+
+        // Executes Ready-value mode over selected columns only (overload)
+        template <std::invocable<std::string_view> H, std::invocable<std::string_view> F, std::invocable R = decltype(no_row)>
+        void run(columns const & selected, H && hfcb, F && fcb, R && nrc = {}) const {
+            run_selected<true, true>(selected, hfcb, fcb, nrc);
+        }
+
+        // Executes Spanning mode over selected columns only
+        template <std::invocable<cell_span const &> F, std::invocable R = decltype(no_row)>
+        void run_span(columns const & selected, F && fcb, R && nrc = {}) const {
+            run_selected<false, false>(selected, no_field, fcb, nrc);
+        }
+
+        // Executes Spanning mode over selected columns only (overload)
+        template <std::invocable<cell_span const &> H, std::invocable<cell_span const &> F, std::invocable R = decltype(no_row)>
+        void run_span(columns const & selected, H && hfcb, F && fcb, R && nrc = {}) const {
+            run_selected<false, true>(selected, hfcb, fcb, nrc);
+        }
+
+        // Executes Row mode: the callable gets spans of all fields of a row (std::span<cell_span const>) at once,
+        // and may return control::stop. Spans are valid during the call only.
+        template <std::invocable<std::span<cell_span const>> F>
+        void run_rows(F && rcb) const {
+            run_rows_of<false>(no_field, rcb);
+        }
+
+        // Executes Row mode (overload): the header row goes to its own callable
+        template <std::invocable<std::span<cell_span const>> H, std::invocable<std::span<cell_span const>> F>
+        void run_rows(H && hrcb, F && rcb) const {
+            run_rows_of<true>(hrcb, rcb);
+        }
+
+        // Executes Block mode: the callable gets blocks of rows (row_block const &) by columns, of `rows` rows
+        // but the last one, and may return control::stop. All rows must have the same number of fields.
+        template <std::invocable<row_block const &> F>
+        void run_blocks(std::size_t rows, F && bcb) const {
+            run_blocks_of<false>(rows, no_field, bcb);
+        }
+
+        // Executes Block mode (overload): the header row goes to its own callable, as a block of a row
+        template <std::invocable<row_block const &> H, std::invocable<row_block const &> F>
+        void run_blocks(std::size_t rows, H && hbcb, F && bcb) const {
+            run_blocks_of<true>(rows, hbcb, bcb);
+        }
+
+        // Records (rows) of a source as an input range of spans of their fields, the header's too:
+        //     for (auto const & row : r.records()) { row[0].read_value(s); }
+        // The source is read as far as rows are pulled (views::take() stops reading). A range of records and
+        // its rows do not outlive the reader. It may be handed over to another thread, not walked concurrently.
+        [[nodiscard]] auto records() const & -> record_range {
+            return std::visit([this](auto const & arg) { return pull_records(arg); }, src);
+        }
+        auto records() const && -> record_range = delete;
+
+        // Executes Spanning mode on several threads (0 - as many as the hardware runs concurrently).
+        // Callbacks get the number of a part of the source, which is processed by its own thread.
+        // Parts are sequences of whole rows in order of their numbers; callbacks of different parts interleave.
+        void run_span_parallel(std::size_t threads, value_field_span_par_cb_t fcb,
+                               new_row_par_cb_t nrc = [](std::size_t) {}) const {
+            span_parallel(threads, 0, [](cell_span const &) {}, fcb, nrc);
+        }
+
+        // Executes Spanning mode on several threads (overload). Header fields are all reported by part 0.
+        void run_span_parallel(std::size_t threads, header_field_span_cb_t hfcb, value_field_span_par_cb_t fcb,
+                               new_row_par_cb_t nrc = [](std::size_t) {}) const {
+            span_parallel(threads, cols(), hfcb, fcb, nrc);
+        }
+
+        // Builds the index of rows' offsets, honoring LFs inside quotes, on several threads
+        // (0 - as many as the hardware runs concurrently). Returns rows
+        auto index_rows(std::size_t threads = 1) const -> std::size_t {
+            auto const whole = whole_source();
+            if (whole.empty()) {
+                throw exception ("Use of Move-From state object");
+            }
+            auto const ranges = split(whole, threads);
+            std::vector<std::vector<std::size_t>> starts (ranges.size());
+            auto unclosed {false};
+            in_parallel(ranges.size(), [&](std::size_t i) {
+                auto quoted {false};
+                starts[i] = row_starts(whole, ranges[i], quoted);
+                // Only the part ending the source may end inside quotes
+                if (!ranges[i].empty() && ranges[i].data() + ranges[i].size() == whole.data() + whole.size()) {
+                    unclosed = quoted;
+                }
+            });
+
+            std::vector<std::size_t> offsets {0};
+            for (auto const & part : starts) {
+                offsets.insert(offsets.end(), part.begin(), part.end());
+            }
+            // The last row lacking LF ends with the source, unless it ends inside quotes (as runs skip it)
+            if (offsets.back() != whole.size() && !unclosed) {
+                offsets.push_back(whole.size());
+            }
+            row_index = std::move(offsets);
+            rows_memo.set(row_index.size() - 1);
+            return row_index.size() - 1;
+        }
+
+        // Sidecar file of the index of rows of a CSV file, taken by the reader of this file if it matches the file
+        [[nodiscard]] static auto index_path(std::filesystem::path const & csv_src) -> std::filesystem::path {
+            auto sidecar = csv_src;
+            sidecar += ".idx";
+            return sidecar;
+        }
+
+        // Saves the index of rows (building it if there is none) to the sidecar file of the CSV file.
+        // The sidecar is replaced at once, so that readers in other processes never see it half-written.
+        void save_index() const {
+            auto const key = index_key(src_path);
+            if (!key) {
+                throw exception ("Only CSV files have sidecar index files");
+            }
+            if (row_index.empty()) {
+                index_rows();
+            }
+            auto const sidecar = index_path(src_path);
+            auto temporary = sidecar;
+            temporary += ".tmp";
+            {
+                std::ofstream out (temporary, std::ios::binary | std::ios::trunc);
+                std::uint64_t const offsets {row_index.size()};
+                std::vector<std::uint64_t> const index (row_index.begin(), row_index.end());
+                out.write(reinterpret_cast<char const *>(key->data()), sizeof(*key));
+                out.write(reinterpret_cast<char const *>(&offsets), sizeof(offsets));
+                out.write(reinterpret_cast<char const *>(index.data()), static_cast<std::streamsize>(offsets * sizeof(std::uint64_t)));
+                if (!out.flush()) {
+                    throw exception ("Cannot write : ", temporary.string());
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(temporary, sidecar, error);
+            if (error) {
+                throw exception (error.message(), " : ", sidecar.string());
+            }
+        }
+
+        // Executes Spanning mode over rows [first, last) only, building the index of rows if there is none
+        void rows(std::size_t first, std::size_t last, value_field_span_cb_t fcb, new_row_cb_t nrc= [] {}) const {
+            if (first > last) {
+                throw exception ("Row index out of range: ", first);
+            }
+            auto const b = indexed_row(first);
+            auto const e = indexed_row(last);
+            walk_span(whole_source().subspan(b, e - b), 0, 0, [](cell_span const &) {}
+                , [&fcb](cell_span const & span, std::size_t) { fcb(span); }
+                , [&nrc](std::size_t) { nrc(); });
+        }
+
+        // Executes Spanning mode over row i only
+        void row(std::size_t i, value_field_span_cb_t fcb) const {
+            rows(i, i + 1, std::move(fcb));
+        }
+
+        // Executes Ready-value mode, checking validity in the same pass: throws at the first row
+        // whose columns differ from the first row's (before delivering its excess fields). Returns rows.
+        auto run_valid(value_field_cb_t fcb, new_row_cb_t nrc=[]{}) const -> std::size_t {
+            vf_cb = std::move(fcb);
+            new_row_cb = std::move(nrc);
+            return run_checked(false);
+        }
+
+        // Executes Ready-value mode, checking validity in the same pass (overload)
+        auto run_valid(header_field_cb_t hfcb, value_field_cb_t fcb, new_row_cb_t nrc=[]{}) const -> std::size_t {
             hf_cb = std::move(hfcb);
             vf_cb = std::move(fcb);
             new_row_cb = std::move(nrc);
-            std::visit([&](auto&& arg) {
-                auto columns = cols();
-                auto source = sender(arg);
-                auto p = parse();
-
-                for (auto const & b: source) {
-                    p.send(b);
-                    if (const auto &res = p(); !res.empty()) {
-                        !columns ? vf_cb(std::string_view{res.begin(),res.end()-1}) :
-                        hf_cb(std::string_view{res.begin(),res.end()-1});
-                        columns = columns ? columns-1 : 0;
-                        if (LF == res.back()) {
-                            new_row_cb();
-                        }
-                    }
-                }
-            }, src);
+            return run_checked(true);
         }
 
-        // Executes Spanning mode (overload)
-        void run_span(header_field_span_cb_t hfcb, value_field_span_cb_t fcb, new_row_cb_t nrc= [] {}) const {
-            hfcs_cb = std::move(hfcb);
+        // Executes Spanning mode, checking validity in the same pass. Returns rows.
+        auto run_span_valid(value_field_span_cb_t fcb, new_row_cb_t nrc= [] {}) const -> std::size_t {
             vfcs_cb = std::move(fcb);
             new_row_cb = std::move(nrc);
+            return run_span_checked(false, hfcs_cb, vfcs_cb);
+        }
 
-            std::visit([this](auto&& arg) noexcept {
-                auto columns = cols();
-                auto source = span_sender(arg);
-                auto p = parse_cell_span();
-
-                for (auto const & b: source) {
-                    p.send(b);
-                    if (const auto & r = p(); r()) {
-                        auto res = r;
-                        res.e--;
-                        !columns ? vfcs_cb(res) : hfcs_cb(res);
-                        columns = columns ? columns-1 : 0;
-                        if (*res.e == LF) {
-                            new_row_cb();
-                        }
-                    }
-                }
-
-                // In spanning mode last LF (if not in source) - gives no chance to dereference the source.
-                // Because dereference would come to non-existent position: the end().
-                // So we have to go for the trick. Otherwise, we would have to double-check for
-                // every one field in the cycle above. (See revision history)
-
-                last_LF(arg, p);
-            }, src);
+        // Executes Spanning mode, checking validity in the same pass (overload)
+        auto run_span_valid(header_field_span_cb_t hfcb, value_field_span_cb_t fcb, new_row_cb_t nrc= [] {}) const
+            -> std::size_t {
+            hfcs_cb = std::move(hfcb);
+            vfcs_cb = std::move(fcb);
+            new_row_cb = std::move(nrc);
+            return run_span_checked(true, hfcs_cb, vfcs_cb);
         }
 
         struct exception : public std::runtime_error {
@@ -741,7 +2118,7 @@ namespace csv_co {
 
             template <typename T>
             void save_detail(T && v) {
-                if constexpr(std::is_arithmetic_v<T>)
+                if constexpr(std::is_arithmetic_v<std::remove_cvref_t<T>>)
                     msg += std::to_string(v);
                 else
                     msg += v;
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+#include <bit>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define CSV_CO_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+// Vector kernels are compiled for their own instruction sets, whatever the rest of a binary is built for
+#if defined(CSV_CO_X86) && !defined(_MSC_VER)
+    #define CSV_CO_TARGET(isa_name) __attribute__((target(isa_name)))
+#else
+    #define CSV_CO_TARGET(isa_name)
+#endif
+
+namespace csv_co::simd {
+
+    // Structural characters are indexed by 64-byte blocks: bit i of a block's word stands for its byte i
+    constexpr std::size_t block_size = 64;
+
+    [[nodiscard]] constexpr auto blocks(std::size_t size) noexcept -> std::size_t {
+        return (size + block_size - 1) / block_size;
+    }
+
+    enum class isa { scalar, sse2, avx2 };
+
+    // Bitmaps of a chunk: one word per block for each kind of structural characters
+    struct bitmaps {
+        std::uint64_t * quotes;
+        std::uint64_t * delimiters;
+        std::uint64_t * lfs;
+    };
+
+    namespace scalar {
+        template <char Quote, char Delimiter>
+        void index(char const * data, std::size_t n, bitmaps out) noexcept {
+            for (std::size_t block = 0; block < n; block++, data += block_size) {
+                std::uint64_t q {0}, d {0}, lf {0};
+                for (std::size_t i = 0; i < block_size; i++) {
+                    q |= static_cast<std::uint64_t>(data[i] == Quote) << i;
+                    d |= static_cast<std::uint64_t>(data[i] == Delimiter) << i;
+                    lf |= static_cast<std::uint64_t>(data[i] == '\n') << i;
+                }
+                out.quotes[block] = q;
+                out.delimiters[block] = d;
+                out.lfs[block] = lf;
+            }
+        }
+
+        // Bit i of the result is the parity of quotes at positions [0, i]
+        [[nodiscard]] inline auto prefix_xor(std::uint64_t x) noexcept -> std::uint64_t {
+            x ^= x << 1;
+            x ^= x << 2;
+            x ^= x << 4;
+            x ^= x << 8;
+            x ^= x << 16;
+            x ^= x << 32;
+            return x;
+        }
+
+        // Turns quote bitmaps into masks of quoted areas. carry is all ones while a quoted area is open
+        inline void inside_quotes(std::uint64_t * quotes, std::size_t n, std::uint64_t & carry) noexcept {
+            for (std::size_t block = 0; block < n; block++) {
+                auto const inside = prefix_xor(quotes[block]) ^ carry;
+                quotes[block] = inside;
+                carry = 0 - (inside >> 63);
+            }
+        }
+    }
+
+#if defined(CSV_CO_X86)
+    namespace sse2 {
+        CSV_CO_TARGET("sse2")
+        inline auto equal_mask(__m128i v, __m128i c) noexcept -> std::uint64_t {
+            return static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)));
+        }
+
+        template <char Quote, char Delimiter>
+        CSV_CO_TARGET("sse2")
+        void index(char const * data, std::size_t n, bitmaps out) noexcept {
+            auto const q = _mm_set1_epi8(Quote);
+            auto const d = _mm_set1_epi8(Delimiter);
+            auto const lf = _mm_set1_epi8('\n');
+            for (std::size_t block = 0; block < n; block++, data += block_size) {
+                std::uint64_t qm {0}, dm {0}, lfm {0};
+                for (std::size_t i = 0; i < block_size / 16; i++) {
+                    auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + 16 * i));
+                    qm |= equal_mask(v, q) << (16 * i);
+                    dm |= equal_mask(v, d) << (16 * i);
+                    lfm |= equal_mask(v, lf) << (16 * i);
+                }
+                out.quotes[block] = qm;
+                out.delimiters[block] = dm;
+                out.lfs[block] = lfm;
+            }
+        }
+    }
+
+    namespace avx2 {
+        CSV_CO_TARGET("avx2")
+        inline auto equal_mask(__m256i lo, __m256i hi, __m256i c) noexcept -> std::uint64_t {
+            auto const l = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, c)));
+            auto const h = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, c)));
+            return static_cast<std::uint64_t>(h) << 32 | l;
+        }
+
+        template <char Quote, char Delimiter>
+        CSV_CO_TARGET("avx2")
+        void index(char const * data, std::size_t n, bitmaps out) noexcept {
+            auto const q = _mm256_set1_epi8(Quote);
+            auto const d = _mm256_set1_epi8(Delimiter);
+            auto const lf = _mm256_set1_epi8('\n');
+            for (std::size_t block = 0; block < n; block++, data += block_size) {
+                auto const lo = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data));
+                auto const hi = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data + 32));
+                out.quotes[block] = equal_mask(lo, hi, q);
+                out.delimiters[block] = equal_mask(lo, hi, d);
+                out.lfs[block] = equal_mask(lo, hi, lf);
+            }
+        }
+    }
+
+    namespace clmul {
+        // Carry-less multiplication by all ones is the prefix XOR
+        CSV_CO_TARGET("pclmul")
+        inline auto prefix_xor(std::uint64_t x) noexcept -> std::uint64_t {
+            auto const product = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(x)), _mm_set1_epi8(-1), 0);
+            return static_cast<std::uint64_t>(_mm_cvtsi128_si64(product));
+        }
+
+        CSV_CO_TARGET("pclmul")
+        inline void inside_quotes(std::uint64_t * quotes, std::size_t n, std::uint64_t & carry) noexcept {
+            for (std::size_t block = 0; block < n; block++) {
+                auto const inside = prefix_xor(quotes[block]) ^ carry;
+                quotes[block] = inside;
+                carry = 0 - (inside >> 63);
+            }
+        }
+    }
+#endif
+
+    // Best instruction set of the running CPU (for binaries built without -march=native)
+    [[nodiscard]] inline auto detect() noexcept -> isa {
+#if defined(CSV_CO_X86)
+    #if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        bool const os_saves_ymm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+        __cpuidex(info, 7, 0);
+        return (os_saves_ymm && (info[1] & (1 << 5))) ? isa::avx2 : isa::sse2;
+    #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? isa::avx2 : isa::sse2;
+    #endif
+#else
+        return isa::scalar;
+#endif
+    }
+
+    [[nodiscard]] inline auto supported() noexcept -> isa {
+        static isa const best = detect();
+        return best;
+    }
+
+    [[nodiscard]] inline auto clmul_supported() noexcept -> bool {
+#if defined(CSV_CO_X86)
+    #if defined(_MSC_VER)
+        static bool const clmul = [] {
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 1)) != 0;
+        }();
+        return clmul;
+    #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("pclmul");
+    #endif
+#else
+        return false;
+#endif
+    }
+
+    // Indexes n whole blocks with the vector path the build targets, or the one the CPU supports
+    template <char Quote, char Delimiter>
+    void index_blocks(char const * data, std::size_t n, bitmaps out) noexcept {
+#if defined(__AVX2__)
+        avx2::index<Quote, Delimiter>(data, n, out);
+#else
+        switch (supported()) {
+    #if defined(CSV_CO_X86)
+            case isa::avx2: avx2::index<Quote, Delimiter>(data, n, out); break;
+            case isa::sse2: sse2::index<Quote, Delimiter>(data, n, out); break;
+    #endif
+            default: scalar::index<Quote, Delimiter>(data, n, out);
+        }
+#endif
+    }
+
+    // Builds bitmaps of quote, delimiter and LF positions of a chunk.
+    // Arrays must hold blocks(chunk.size()) words. Bits past the chunk's end are zero.
+    template <char Quote, char Delimiter>
+    void index(std::span<char const> chunk, bitmaps out) noexcept {
+        auto const whole = chunk.size() / block_size;
+        index_blocks<Quote, Delimiter>(chunk.data(), whole, out);
+        if (auto const rest = chunk.size() % block_size) {
+            alignas(block_size) char tail[block_size] {};
+            std::memcpy(tail, chunk.data() + whole * block_size, rest);
+            index_blocks<Quote, Delimiter>(tail, 1, {out.quotes + whole, out.delimiters + whole, out.lfs + whole});
+            auto const valid = (std::uint64_t{1} << rest) - 1;
+            out.quotes[whole] &= valid;
+            out.delimiters[whole] &= valid;
+            out.lfs[whole] &= valid;
+        }
+    }
+
+    inline void inside_quotes(std::uint64_t * quotes, std::size_t n, std::uint64_t & carry) noexcept {
+#if defined(__PCLMUL__)
+        clmul::inside_quotes(quotes, n, carry);
+#else
+    #if defined(CSV_CO_X86)
+        if (clmul_supported()) {
+            clmul::inside_quotes(quotes, n, carry);
+            return;
+        }
+    #endif
+        scalar::inside_quotes(quotes, n, carry);
+#endif
+    }
+
+    // Delimiters and LFs of consecutive chunks of a source, which stand outside quoted areas.
+    // Quotes are paired within a field, so the parity of all quotes met tells if we are inside.
+    template <char Quote, char Delimiter>
+    class structural_index {
+        std::vector<std::uint64_t> inside;
+        std::vector<std::uint64_t> delimiters_;
+        std::vector<std::uint64_t> lfs_;
+        std::size_t blocks_ {0};
+        std::uint64_t carry {0};
+
+    public:
+        explicit structural_index(std::size_t max_chunk_size)
+            : inside(blocks(max_chunk_size)), delimiters_(blocks(max_chunk_size)), lfs_(blocks(max_chunk_size)) {}
+
+        void build(std::span<char const> chunk) noexcept {
+            blocks_ = blocks(chunk.size());
+            index<Quote, Delimiter>(chunk, {inside.data(), delimiters_.data(), lfs_.data()});
+            inside_quotes(inside.data(), blocks_, carry);
+            for (std::size_t block = 0; block < blocks_; block++) {
+                delimiters_[block] &= ~inside[block];
+                lfs_[block] &= ~inside[block];
+            }
+        }
+
+        [[nodiscard]] auto size() const noexcept { return blocks_; }
+        [[nodiscard]] auto delimiters(std::size_t block) const noexcept { return delimiters_[block]; }
+        [[nodiscard]] auto lfs(std::size_t block) const noexcept { return lfs_[block]; }
+        [[nodiscard]] auto limiters(std::size_t block) const noexcept { return delimiters_[block] | lfs_[block]; }
+        // Whether the last chunk ended inside a quoted area
+        [[nodiscard]] auto quoted() const noexcept { return carry != 0; }
+    };
+
+    // What a part of a source looks like for both guesses on whether it starts inside a quoted area.
+    // Once parities of all preceding parts are known, the right guess gives the part's first row end.
+    struct speculation {
+        static constexpr std::size_t none = static_cast<std::size_t>(-1);
+        // Offsets of the first LF standing outside quotes: if the part starts outside, or inside quotes
+        std::size_t first_lf[2] {none, none};
+        bool odd_quotes {false};
+    };
+
+    template <char Quote, char Delimiter>
+    [[nodiscard]] auto speculate(std::span<char const> part, std::size_t piece_size) -> speculation {
+        speculation result;
+        std::vector<std::uint64_t> quotes(blocks(piece_size)), delimiters(blocks(piece_size)), lfs(blocks(piece_size));
+        std::uint64_t carry {0};
+        for (std::size_t offset = 0; offset < part.size(); offset += piece_size) {
+            auto const piece = part.subspan(offset, std::min(piece_size, part.size() - offset));
+            auto const n = blocks(piece.size());
+            index<Quote, Delimiter>(piece, {quotes.data(), delimiters.data(), lfs.data()});
+            inside_quotes(quotes.data(), n, carry);
+            for (std::size_t block = 0; block < n && std::ranges::count(result.first_lf, speculation::none); block++) {
+                auto const outside = lfs[block] & ~quotes[block];
+                auto const inside = lfs[block] & quotes[block];
+                for (auto const & [guess, bits] : {std::pair{0, outside}, std::pair{1, inside}}) {
+                    if (bits && result.first_lf[guess] == speculation::none) {
+                        result.first_lf[guess] = offset + block * block_size + std::countr_zero(bits);
+                    }
+                }
+            }
+        }
+        result.odd_quotes = carry != 0;
+        return result;
+    }
+
+} // namespace
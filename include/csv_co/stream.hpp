@@ -0,0 +1,706 @@
+#pragma once
+
+#include <cstddef>
+#include <cerrno>
+#include <istream>
+#include <system_error>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <span>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
+
+#if defined(CSV_CO_LIBURING)
+    #include <liburing.h>
+#endif
+
+#if defined(CSV_CO_ZLIB)
+    #include <zlib.h>
+#endif
+
+#if defined(CSV_CO_ZSTD)
+    #include <zstd.h>
+#endif
+
+namespace csv_co {
+
+    // Reading a stream source ahead, on a thread of its own: some buffers are being filled while others are parsed
+    struct read_ahead {
+        std::size_t buffers {2};
+        std::size_t buffer_size {64 * 1024};
+    };
+
+#ifndef _WIN32
+    // Reads of a file kept in flight, in order of the file's offsets
+    struct in_flight {
+        std::size_t reads {4};
+        std::size_t read_size {1024 * 1024};
+    };
+
+    // Reads of a file into a ring of buffers, several of them in flight: submitted to an io_uring where built
+    // with liburing (CSV_CO_LIBURING) and the kernel supports it, or done by pread when taken otherwise
+    class file_reads {
+        int fd {-1};
+        std::uint64_t size {0};
+        std::size_t read_size;
+        std::vector<std::vector<char>> buffers;
+        // Chars of completed reads
+        std::vector<std::size_t> lengths;
+        std::vector<char> completed;
+        // Read being taken, and chars taken of it
+        std::uint64_t head {0};
+        std::size_t offset {0};
+#if defined(CSV_CO_LIBURING)
+        io_uring ring {};
+        bool uring {false};
+        bool stalled {false}; // a submission failed
+        std::size_t pending {0};
+#endif
+
+        [[nodiscard]] auto reads() const noexcept -> std::uint64_t {
+            return (size + read_size - 1) / read_size;
+        }
+
+        [[nodiscard]] auto extent(std::uint64_t i) const noexcept -> std::size_t {
+            return static_cast<std::size_t>(std::min<std::uint64_t>(read_size, size - i * read_size));
+        }
+
+        // Completes read i by pread (the whole of it, or the rest of a short one)
+        auto fill(std::uint64_t i, std::error_code & error) noexcept -> bool {
+            auto & length = lengths[i % buffers.size()];
+            auto const to = buffers[i % buffers.size()].data();
+            while (length < extent(i)) {
+                auto const r = ::pread(fd, to + length, extent(i) - length, static_cast<off_t>(i * read_size + length));
+                if (r < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (r <= 0) {
+                    error = r < 0 ? std::error_code(errno, std::generic_category()) : std::make_error_code(std::errc::io_error);
+                    return false;
+                }
+                length += static_cast<std::size_t>(r);
+            }
+            return true;
+        }
+
+        void submit(std::uint64_t i) noexcept {
+            lengths[i % buffers.size()] = 0;
+            completed[i % buffers.size()] = false;
+#if defined(CSV_CO_LIBURING)
+            if (uring && !stalled && i < reads()) {
+                // Not submitted, it is done by pread when taken
+                if (auto const sqe = io_uring_get_sqe(&ring)) {
+                    io_uring_prep_read(sqe, fd, buffers[i % buffers.size()].data(), static_cast<unsigned>(extent(i)), i * read_size);
+                    io_uring_sqe_set_data(sqe, reinterpret_cast<void *>(static_cast<std::uintptr_t>(i)));
+                    if (auto const r = io_uring_submit(&ring); r > 0) {
+                        pending += static_cast<std::size_t>(r);
+                    } else {
+                        // The read stays queued: no more submissions could send it later, into a buffer reused
+                        // by then. It and the next reads are done by pread, reads in flight are still waited for.
+                        stalled = true;
+                    }
+                }
+            }
+#endif
+        }
+
+        auto complete(std::uint64_t i, std::error_code & error) noexcept -> bool {
+#if defined(CSV_CO_LIBURING)
+            while (pending && !completed[i % buffers.size()]) {
+                io_uring_cqe * cqe {nullptr};
+                if (auto const r = io_uring_wait_cqe(&ring, &cqe); r < 0) {
+                    if (r == -EINTR) {
+                        continue;
+                    }
+                    error = std::error_code(-r, std::generic_category());
+                    return false;
+                }
+                auto const j = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(io_uring_cqe_get_data(cqe)));
+                auto const res = cqe->res;
+                io_uring_cqe_seen(&ring, cqe);
+                pending--;
+                if (res < 0) {
+                    error = std::error_code(-res, std::generic_category());
+                    return false;
+                }
+                lengths[j % buffers.size()] = static_cast<std::size_t>(res);
+                completed[j % buffers.size()] = true;
+            }
+#endif
+            completed[i % buffers.size()] = true;
+            return fill(i, error);
+        }
+
+    public:
+        file_reads(std::filesystem::path const & file, in_flight ahead)
+            : read_size {std::max<std::size_t>(1, ahead.read_size)}
+            , buffers(std::max<std::size_t>(1, ahead.reads), std::vector<char>(read_size))
+            , lengths(buffers.size()), completed(buffers.size()) {
+            std::error_code error;
+            size = std::filesystem::file_size(file, error);
+            if (!error && (fd = ::open(file.c_str(), O_RDONLY)) < 0) {
+                error = std::error_code(errno, std::generic_category());
+            }
+            if (error) {
+                throw std::filesystem::filesystem_error("Cannot read", file, error);
+            }
+#if defined(CSV_CO_LIBURING)
+            uring = io_uring_queue_init(static_cast<unsigned>(buffers.size()), &ring, 0) == 0;
+#endif
+            for (std::uint64_t i = 0; i < buffers.size(); i++) {
+                submit(i);
+            }
+        }
+
+        file_reads(file_reads const &) = delete;
+        auto operator=(file_reads const &) -> file_reads & = delete;
+
+        // All reads in flight are waited for before the ring goes: the kernel writes to their buffers
+        ~file_reads() {
+#if defined(CSV_CO_LIBURING)
+            for (io_uring_cqe * cqe {nullptr}; pending; ) {
+                if (auto const r = io_uring_wait_cqe(&ring, &cqe); r == 0) {
+                    io_uring_cqe_seen(&ring, cqe);
+                    pending--;
+                } else
+                if (r != -EINTR) {
+                    break;
+                }
+            }
+            if (uring) {
+                io_uring_queue_exit(&ring);
+            }
+#endif
+            ::close(fd);
+        }
+
+        // Reads up to n chars, fewer only at the end of the file. Returns chars read
+        auto read(char * to, std::size_t n, std::error_code & error) noexcept -> std::size_t {
+            std::size_t done {0};
+            while (done < n && head < reads()) {
+                if (!offset && !complete(head, error)) {
+                    head = reads();
+                    break;
+                }
+                auto const length = lengths[head % buffers.size()];
+                auto const chars = std::min(n - done, length - offset);
+                auto const from = buffers[head % buffers.size()].data() + offset;
+                std::copy(from, from + chars, to + done);
+                done += chars;
+                offset += chars;
+                if (offset == length) {
+                    offset = 0;
+                    submit(head + buffers.size());
+                    head++;
+                }
+            }
+            return done;
+        }
+    };
+#endif
+
+    // Compression formats of files, told by their magic bytes
+    enum class compression { none, gzip, zstd };
+
+    inline auto compression_of(std::filesystem::path const & file) noexcept -> compression {
+        std::array<unsigned char, 4> magic {};
+        std::ifstream in (file, std::ios::binary);
+        in.read(reinterpret_cast<char *>(magic.data()), magic.size());
+        if (in.gcount() >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+            return compression::gzip;
+        }
+        if (in.gcount() == 4 && magic == std::array<unsigned char, 4>{0x28, 0xb5, 0x2f, 0xfd}) {
+            return compression::zstd;
+        }
+        return compression::none;
+    }
+
+    // Decompressing a file on a thread of its own, ahead of parsing (or on the parser's one, for no buffers)
+    struct decompress {
+        read_ahead ahead {4, 256 * 1024};
+    };
+
+    // A compressed file decompressed right into the buffers it is read to: gzip (concatenated members as well)
+    // by zlib where built with it (CSV_CO_ZLIB), zstd by libzstd where built with it (CSV_CO_ZSTD)
+    class decompressed_file {
+        std::ifstream file;
+        compression format;
+        // Compressed chars read, and the part of them not decompressed yet
+        std::vector<char> input;
+        char const * next {nullptr};
+        std::size_t left {0};
+        // A gzip member or a zstd frame is begun, but not ended
+        bool within {false};
+        bool ended {false};
+#if defined(CSV_CO_ZLIB)
+        z_stream z {};
+#endif
+#if defined(CSV_CO_ZSTD)
+        ZSTD_DCtx * zstd {nullptr};
+#endif
+
+        // Reads compressed chars once all of them are decompressed
+        void refill(std::error_code & error) noexcept {
+            if (left) {
+                return;
+            }
+            file.read(input.data(), static_cast<std::streamsize>(input.size()));
+            if (file.bad()) {
+                error = std::make_error_code(std::errc::io_error);
+            }
+            next = input.data();
+            left = static_cast<std::size_t>(file.gcount());
+        }
+
+        // Ends decompression at the end of the file, or on an error: a member or a frame cut short is an error
+        auto end(std::error_code & error, bool corrupt) noexcept -> bool {
+            if (!error && (corrupt || within)) {
+                error = std::make_error_code(std::errc::bad_message);
+            }
+            ended = true;
+            return false;
+        }
+
+#if defined(CSV_CO_ZLIB)
+        auto inflate_to(char * to, std::size_t n, std::error_code & error) noexcept -> std::size_t {
+            z.next_out = reinterpret_cast<Bytef *>(to);
+            z.avail_out = static_cast<uInt>(std::min<std::size_t>(n, UINT_MAX));
+            auto const wanted = z.avail_out;
+            while (z.avail_out && !ended) {
+                refill(error);
+                if (error) {
+                    end(error, false);
+                    break;
+                }
+                z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(next));
+                z.avail_in = static_cast<uInt>(std::min<std::size_t>(left, UINT_MAX));
+                if (!z.avail_in && !within) {
+                    end(error, false);
+                    break;
+                }
+                auto const r = ::inflate(&z, Z_NO_FLUSH);
+                auto const used = static_cast<std::size_t>(reinterpret_cast<char const *>(z.next_in) - next);
+                next += used;
+                left -= used;
+                within = true;
+                if (r == Z_STREAM_END) {
+                    // Next member, if any
+                    within = false;
+                    ::inflateReset(&z);
+                } else
+                if (r != Z_OK) {
+                    // No progress for the lack of input (a member cut short), or corrupt data
+                    end(error, r != Z_BUF_ERROR);
+                }
+            }
+            return wanted - z.avail_out;
+        }
+#endif
+
+#if defined(CSV_CO_ZSTD)
+        auto zstd_to(char * to, std::size_t n, std::error_code & error) noexcept -> std::size_t {
+            ZSTD_outBuffer out {to, n, 0};
+            while (out.pos < out.size && !ended) {
+                refill(error);
+                if (error) {
+                    end(error, false);
+                    break;
+                }
+                if (!left && !within) {
+                    end(error, false);
+                    break;
+                }
+                ZSTD_inBuffer in {next, left, 0};
+                auto const before = out.pos;
+                auto const r = ZSTD_decompressStream(zstd, &out, &in);
+                next += in.pos;
+                left -= in.pos;
+                if (ZSTD_isError(r)) {
+                    end(error, true);
+                    break;
+                }
+                // 0 - a frame is done and flushed
+                within = r != 0;
+                if (!in.pos && out.pos == before) {
+                    end(error, false);
+                }
+            }
+            return out.pos;
+        }
+#endif
+
+    public:
+        static constexpr auto supported(compression format) noexcept -> bool {
+#if defined(CSV_CO_ZLIB)
+            if (format == compression::gzip) {
+                return true;
+            }
+#endif
+#if defined(CSV_CO_ZSTD)
+            if (format == compression::zstd) {
+                return true;
+            }
+#endif
+            return format == compression::none;
+        }
+
+        decompressed_file(std::filesystem::path const & csv_src, std::size_t input_size)
+            : file {csv_src, std::ios::binary}, format {compression_of(csv_src)}
+            , input(std::max<std::size_t>(1, input_size)) {
+            if (!file) {
+                throw std::filesystem::filesystem_error("Cannot read", csv_src, std::make_error_code(std::errc::io_error));
+            }
+            if (!supported(format)) {
+                throw std::filesystem::filesystem_error("Cannot decompress", csv_src, std::make_error_code(std::errc::not_supported));
+            }
+#if defined(CSV_CO_ZLIB)
+            // gzip wrapper
+            if (format == compression::gzip && ::inflateInit2(&z, 16 + MAX_WBITS) != Z_OK) {
+                throw std::bad_alloc();
+            }
+#endif
+#if defined(CSV_CO_ZSTD)
+            if (format == compression::zstd && !(zstd = ZSTD_createDCtx())) {
+                throw std::bad_alloc();
+            }
+#endif
+        }
+
+        decompressed_file(decompressed_file const &) = delete;
+        auto operator=(decompressed_file const &) -> decompressed_file & = delete;
+
+        ~decompressed_file() {
+#if defined(CSV_CO_ZLIB)
+            if (format == compression::gzip) {
+                ::inflateEnd(&z);
+            }
+#endif
+#if defined(CSV_CO_ZSTD)
+            ZSTD_freeDCtx(zstd);
+#endif
+        }
+
+        // Decompresses up to n chars, fewer only at the end of the file. Returns chars decompressed
+        auto read(char * to, std::size_t n, std::error_code & error) noexcept -> std::size_t {
+            std::size_t done {0};
+            while (done < n && !ended) {
+#if defined(CSV_CO_ZLIB)
+                if (format == compression::gzip) {
+                    done += inflate_to(to + done, n - done, error);
+                }
+#endif
+#if defined(CSV_CO_ZSTD)
+                if (format == compression::zstd) {
+                    done += zstd_to(to + done, n - done, error);
+                }
+#endif
+                if (format == compression::none) {
+                    refill(error);
+                    auto const chars = std::min(n - done, left);
+                    std::copy(next, next + chars, to + done);
+                    next += chars;
+                    left -= chars;
+                    done += chars;
+                    if (!chars) {
+                        end(error, false);
+                    }
+                }
+            }
+            return done;
+        }
+    };
+
+    // Source read by chunks, once and in order: an std::istream, a file descriptor (a pipe, a socket) or
+    // a compressed file. A read error ends the source, and is kept to be reported.
+    class stream_source {
+
+        // Reads up to n chars, fewer only at the end of the source. Returns chars read
+        static auto read_from(std::istream * in, int fd, decompressed_file * z, char * to, std::size_t n,
+                              std::error_code & error) noexcept -> std::size_t {
+            if (z) {
+                return z->read(to, n, error);
+            }
+            if (in) {
+                try {
+                    in->read(to, static_cast<std::streamsize>(n));
+                    if (in->bad()) {
+                        error = std::make_error_code(std::errc::io_error);
+                    }
+                    return static_cast<std::size_t>(in->gcount());
+                } catch (...) {
+                    error = std::make_error_code(std::errc::io_error);
+                    return 0;
+                }
+            }
+            std::size_t done {0};
+            while (fd >= 0 && done < n) {
+#ifdef _WIN32
+                auto const r = ::_read(fd, to + done, static_cast<unsigned>(n - done));
+#else
+                auto const r = ::read(fd, to + done, n - done);
+#endif
+                if (r < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (r < 0) {
+                    error = std::error_code(errno, std::generic_category());
+                }
+                if (r <= 0) {
+                    break;
+                }
+                done += static_cast<std::size_t>(r);
+            }
+            return done;
+        }
+
+        // Ring of buffers filled by the reading thread (the producer) and taken by the parser (the consumer).
+        // Both only wait on the counters of buffers filled (tail) and taken (head), which are never locked.
+        class ahead_queue {
+            std::vector<std::vector<char>> buffers;
+            // Chars of filled buffers, 0 - the end of the source
+            std::vector<std::size_t> lengths;
+            std::atomic<std::size_t> head {0};
+            std::atomic<std::size_t> tail {0};
+            std::atomic<bool> stop {false};
+            // Written by the producer before the end of the source is published
+            std::error_code error;
+            // Consumer's state: chars taken of the head buffer, and whether it is lent (see take())
+            std::size_t offset {0};
+            bool lent {false};
+            bool ended {false};
+            std::thread producer;
+
+            void produce(std::istream * in, int fd, decompressed_file * z) noexcept {
+                for (auto t = tail.load(std::memory_order_relaxed); !stop.load(std::memory_order_acquire); t++) {
+                    for (auto h = head.load(std::memory_order_acquire); t - h == buffers.size();
+                         h = head.load(std::memory_order_acquire)) {
+                        if (stop.load(std::memory_order_acquire)) {
+                            return;
+                        }
+                        head.wait(h, std::memory_order_acquire);
+                    }
+                    if (stop.load(std::memory_order_acquire)) {
+                        return;
+                    }
+                    auto & buffer = buffers[t % buffers.size()];
+                    auto const n = read_from(in, fd, z, buffer.data(), buffer.size(), error);
+                    lengths[t % buffers.size()] = n;
+                    tail.store(t + 1, std::memory_order_release);
+                    tail.notify_one();
+                    if (!n) {
+                        return;
+                    }
+                }
+            }
+
+        public:
+            ahead_queue(std::istream * in, int fd, decompressed_file * z, read_ahead ahead)
+                : buffers(std::max<std::size_t>(1, ahead.buffers), std::vector<char>(std::max<std::size_t>(1, ahead.buffer_size)))
+                , lengths(buffers.size()) {
+                producer = std::thread([this, in, fd, z] { produce(in, fd, z); });
+            }
+
+            // Waits for the read in progress, if any
+            ~ahead_queue() {
+                stop.store(true, std::memory_order_release);
+                head.fetch_add(1, std::memory_order_release);
+                head.notify_one();
+                producer.join();
+            }
+
+            // Gives the head buffer back to the producer
+            void release(std::size_t h) noexcept {
+                offset = 0;
+                lent = false;
+                head.store(h + 1, std::memory_order_release);
+                head.notify_one();
+            }
+
+            // Waits for the head buffer to be filled. Returns its chars, 0 - the end of the source
+            auto filled(std::size_t h, std::error_code & read_error) noexcept -> std::size_t {
+                for (auto t = tail.load(std::memory_order_acquire); t == h; t = tail.load(std::memory_order_acquire)) {
+                    tail.wait(t, std::memory_order_acquire);
+                }
+                auto const length = lengths[h % buffers.size()];
+                if (!length) {
+                    ended = true;
+                    read_error = error;
+                }
+                return length;
+            }
+
+            auto read(char * to, std::size_t n, std::error_code & read_error) noexcept -> std::size_t {
+                if (lent) {
+                    release(head.load(std::memory_order_relaxed));
+                }
+                std::size_t done {0};
+                while (done < n && !ended) {
+                    auto const h = head.load(std::memory_order_relaxed);
+                    auto const length = filled(h, read_error);
+                    if (!length) {
+                        break;
+                    }
+                    auto const chars = std::min(n - done, length - offset);
+                    auto const from = buffers[h % buffers.size()].data() + offset;
+                    std::copy(from, from + chars, to + done);
+                    done += chars;
+                    offset += chars;
+                    if (offset == length) {
+                        release(h);
+                    }
+                }
+                return done;
+            }
+
+            // The rest of the head buffer, lent without copying it: it goes back to the producer by the next
+            // take() or read(). Empty at the end of the source
+            auto take(std::error_code & read_error) noexcept -> std::span<char const> {
+                if (lent) {
+                    release(head.load(std::memory_order_relaxed));
+                }
+                auto const h = head.load(std::memory_order_relaxed);
+                if (ended) {
+                    return {};
+                }
+                auto const length = filled(h, read_error);
+                if (!length) {
+                    return {};
+                }
+                lent = true;
+                return {buffers[h % buffers.size()].data() + offset, length - offset};
+            }
+        };
+
+        std::istream * in {nullptr};
+        int fd {-1};
+        mutable std::error_code error_;
+        read_ahead ahead {0, 0};
+        // Read by the reading thread, if any: destroyed after it
+        std::unique_ptr<decompressed_file> compressed;
+        // Started by the first read
+        mutable std::unique_ptr<ahead_queue> queue;
+        // Chars taken of a source not reading ahead (see take())
+        mutable std::vector<char> taken;
+#ifndef _WIN32
+        std::unique_ptr<file_reads> file;
+#endif
+
+    public:
+        explicit stream_source(std::istream & in) noexcept : in {&in} {}
+        explicit stream_source(int fd) noexcept : fd {fd} {}
+
+        // A reading thread is destroyed with the source, after the read in progress (which may block on a pipe)
+        stream_source(std::istream & in, read_ahead ahead) noexcept : in {&in}, ahead {ahead} {}
+        stream_source(int fd, read_ahead ahead) noexcept : fd {fd}, ahead {ahead} {}
+
+#ifndef _WIN32
+        // A file read with several reads in flight (which overlap parsing): an alternative to its memory mapping
+        explicit stream_source(std::filesystem::path const & csv_src, in_flight reads = {})
+            : file {std::make_unique<file_reads>(csv_src, reads)} {}
+#endif
+
+        // A compressed file (gzip, zstd - told by its magic bytes) decompressed by chunks, as it is parsed
+        stream_source(std::filesystem::path const & csv_src, decompress how)
+            : ahead {how.ahead}, compressed {std::make_unique<decompressed_file>(csv_src, 256 * 1024)} {}
+
+        // A moved-from source reads nothing
+        stream_source(stream_source && other) noexcept
+            : in {std::exchange(other.in, nullptr)}, fd {std::exchange(other.fd, -1)}, error_ {other.error_}
+            , ahead {other.ahead}, compressed {std::move(other.compressed)}, queue {std::move(other.queue)}
+            , taken {std::move(other.taken)} {
+#ifndef _WIN32
+            file = std::move(other.file);
+#endif
+        }
+
+        auto operator=(stream_source && other) noexcept -> stream_source & {
+            in = std::exchange(other.in, nullptr);
+            fd = std::exchange(other.fd, -1);
+            error_ = other.error_;
+            ahead = other.ahead;
+            // The reading thread of the source is stopped first
+            queue = std::move(other.queue);
+            compressed = std::move(other.compressed);
+            taken = std::move(other.taken);
+#ifndef _WIN32
+            file = std::move(other.file);
+#endif
+            return *this;
+        }
+
+        // Reads up to n chars, fewer only at the end of the source. Returns chars read
+        auto read(char * to, std::size_t n) const noexcept -> std::size_t {
+#ifndef _WIN32
+            if (file) {
+                return file->read(to, n, error_);
+            }
+#endif
+            if (reads_ahead()) {
+                auto const q = started_queue();
+                return q ? q->read(to, n, error_) : 0;
+            }
+            return read_from(in, fd, compressed.get(), to, n, error_);
+        }
+
+        // Chars read next: the rest of a buffer read ahead, lent without copying it, or up to n chars read into
+        // a buffer of the source otherwise. They stay valid until the next take() or read(). Empty at the end
+        auto take(std::size_t n) const noexcept -> std::span<char const> {
+            if (reads_ahead()) {
+                auto const q = started_queue();
+                return q ? q->take(error_) : std::span<char const>{};
+            }
+            try {
+                taken.resize(n);
+            } catch (...) {
+                error_ = std::make_error_code(std::errc::not_enough_memory);
+                return {};
+            }
+            return {taken.data(), read(taken.data(), n)};
+        }
+
+        [[nodiscard]] auto error() const noexcept -> std::error_code { return error_; }
+
+        // Whether the source has been moved from (it reads nothing then), rather than having no chars
+        [[nodiscard]] auto moved_from() const noexcept -> bool {
+#ifndef _WIN32
+            if (file) {
+                return false;
+            }
+#endif
+            return !in && fd < 0 && !compressed;
+        }
+
+    private:
+        [[nodiscard]] auto reads_ahead() const noexcept -> bool {
+            return ahead.buffers && (in || fd >= 0 || compressed);
+        }
+
+        // The queue of buffers read ahead, started by the first read. None if its thread cannot be started
+        auto started_queue() const noexcept -> ahead_queue * {
+            if (!queue) {
+                try {
+                    queue = std::make_unique<ahead_queue>(in, fd, compressed.get(), ahead);
+                } catch (...) {
+                    error_ = std::make_error_code(std::errc::resource_unavailable_try_again);
+                    return nullptr;
+                }
+            }
+            return queue.get();
+        }
+    };
+
+} // namespace
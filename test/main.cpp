@@ -2,6 +2,74 @@
 #include "ut.hpp"
 #include <csv_co/reader.hpp>
 #include <fstream>
+#include <memory>
+#include <numeric>
+#include <limits>
+#include <ranges>
+#include <cstring>
+#include <sstream>
+#include <tuple>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#if defined(CSV_CO_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace {
+    using csv_co::cell_string;
+
+    // Quoted LFs, rows straddling chunks and windows (a row longer than chunks too), and the last row lacking LF:
+    // 20003 rows of 3 fields
+    auto straddling_rows() -> cell_string {
+        cell_string src {"h1,h2,h3\n"};
+        for (auto i = 0u; i < 20000; i++) {
+            src += std::to_string(i) + ",\"" + std::to_string(i) + "\n\"\"\"," + cell_string(i % 13, 'x') + "\n";
+            if (i == 10000) {
+                src += "long," + cell_string(100000, 'y') + ",row\n";
+            }
+        }
+        return src + "a,b,";
+    }
+
+    // Values of all fields of a source, by Spanning mode
+    auto span_values(auto const & r) -> std::vector<cell_string> {
+        std::vector<cell_string> v;
+        r.run_span([&v](auto & s) { v.emplace_back(); s.read_value(v.back()); });
+        return v;
+    }
+
+    // Checks readers of a source of every kind: a string, a stream (read ahead by buffers of 100 and of 1000
+    // chars as well), a mapped file, and files mapped by windows of a page and of 4096 pages. check(r, kind) gets
+    // a reader and what kind it is of.
+    void for_each_reader(cell_string const & src, auto && check) {
+        using namespace csv_co;
+        reader whole(src);
+        check(whole, "string");
+
+        std::istringstream in(src);
+        reader streamed(in);
+        check(streamed, "stream");
+        for (auto ahead : {read_ahead{2, 100}, read_ahead{3, 1000}}) {
+            std::istringstream chars(src);
+            reader r(stream_source{chars, ahead});
+            check(r, "read ahead:" + std::to_string(ahead.buffer_size));
+        }
+
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_readers_test.csv";
+        {
+            std::ofstream out (csv, std::ios::binary | std::ios::trunc);
+            out << src;
+        }
+        reader mapped(csv);
+        check(mapped, "mapped");
+        for (std::size_t size : {1u, 4096u}) {
+            reader r(csv, mio::sliding_window{size});
+            check(r, "window:" + std::to_string(size));
+        }
+        std::filesystem::remove(csv);
+    }
+}
 
 int main() {
     using namespace boost::ut;
@@ -75,6 +143,129 @@ int main() {
 
     };
 
+    "Single-pass [unescape] function"_test = [] {
+
+        using namespace string_functions;
+
+        for (cell_string const field : {"", "abc", R"("abc")", R"( "a""b" )", R"("""")", R"("""a")", R"("a""")",
+                                        R"(""")", R"(a""b)", R"(a"b"c)", R"( "a"b)", "\t\"a\"\r\n", R"("a"" " ")",
+                                        R"("""""")", R"(x"""""y)"}) {
+            // As unquote() and unique_quote() give
+            auto expected = field;
+            if (expected.find('"') != cell_string::npos) {
+                unquote(expected, '"');
+            }
+            unique_quote(expected, '"');
+
+            cell_string out (field.size(), '\0');
+            out.resize(unescape(field, '"', out.data()));
+            expect(out == expected) << field;
+
+            // In place
+            auto in_place = field;
+            in_place.resize(unescape(in_place, '"', in_place.data()));
+            expect(in_place == expected) << field;
+        }
+
+        // Ready-value mode takes an opening quote away, closed or not
+        for (auto const & [field, expected] : {std::pair{R"("a"b)", R"(a"b)"}, std::pair{R"( "a""b" )", R"( a"b )"},
+                                               std::pair{R"(a"b")", R"(a"b")"}, std::pair{R"("a"""b)", R"(a"b)"}}) {
+            cell_string out (std::strlen(field), '\0');
+            out.resize(unescape(field, '"', out.data(), true));
+            expect(out == expected) << field;
+        }
+    };
+
+    "Structural index kernels agree with each other"_test = [] {
+
+        using namespace simd;
+
+        cell_string s;
+        for (auto i = 0u; i < 64 * 100 + 17; i++) {
+            s += "ab,\"\n;x"[(i * 7 + i / 3) % 8];
+        }
+        auto const n = blocks(s.size());
+
+        std::vector<std::uint64_t> q(n), d(n), lf(n);
+        index<'"', ','>(s, {q.data(), d.data(), lf.data()});
+
+        auto naive = [&s](std::size_t block, char c) {
+            std::uint64_t bits {0};
+            for (auto i = block * block_size; i < std::min(s.size(), (block + 1) * block_size); i++) {
+                bits |= static_cast<std::uint64_t>(s[i] == c) << (i % block_size);
+            }
+            return bits;
+        };
+        auto mismatches {0u};
+        for (auto block = 0u; block < n; block++) {
+            mismatches += q[block] != naive(block, '"');
+            mismatches += d[block] != naive(block, ',');
+            mismatches += lf[block] != naive(block, '\n');
+        }
+        expect(mismatches == 0);
+
+        auto const whole = s.size() / block_size;
+        std::vector<std::uint64_t> q2(whole), d2(whole), lf2(whole);
+        auto same = [&] {
+            return std::equal(q2.begin(), q2.end(), q.begin()) && std::equal(d2.begin(), d2.end(), d.begin())
+                && std::equal(lf2.begin(), lf2.end(), lf.begin());
+        };
+        scalar::index<'"', ','>(s.data(), whole, {q2.data(), d2.data(), lf2.data()});
+        expect(same());
+#if defined(CSV_CO_X86)
+        sse2::index<'"', ','>(s.data(), whole, {q2.data(), d2.data(), lf2.data()});
+        expect(same());
+        if (supported() == isa::avx2) {
+            avx2::index<'"', ','>(s.data(), whole, {q2.data(), d2.data(), lf2.data()});
+            expect(same());
+        }
+#endif
+    };
+
+    "Quoted areas are masked by prefix XOR of quotes"_test = [] {
+
+        using namespace simd;
+
+        expect(scalar::prefix_xor(0b100100) == 0b011100);
+        expect(scalar::prefix_xor(std::uint64_t{1} << 63) == std::uint64_t{1} << 63);
+        expect(scalar::prefix_xor(1) == ~std::uint64_t{0});
+
+        std::vector<std::uint64_t> quotes {0b1000, 0, 0b10, std::uint64_t{1} << 63};
+        std::uint64_t carry {0};
+        scalar::inside_quotes(quotes.data(), quotes.size(), carry);
+        expect(quotes == std::vector<std::uint64_t>{~std::uint64_t{0} << 3, ~std::uint64_t{0}, 0b1, std::uint64_t{1} << 63});
+        expect(carry == ~std::uint64_t{0});
+
+#if defined(CSV_CO_X86)
+        if (clmul_supported()) {
+            auto mismatches {0u};
+            std::uint64_t x {1};
+            for (auto i = 0u; i < 1000; i++, x = x * 6364136223846793005u + 1442695040888963407u) {
+                mismatches += clmul::prefix_xor(x) != scalar::prefix_xor(x);
+            }
+            expect(mismatches == 0);
+        }
+#endif
+
+        // Limiters inside quotes (even those of fields spanning blocks and chunks) are not limiters at all
+        structural_index<'"', ','> index {128};
+        cell_string s(128, 'x');
+        s[10] = '"'; s[20] = ','; s[30] = '\n'; s[100] = ',';
+        index.build(s);
+        expect(index.size() == 2);
+        expect(index.limiters(0) == 0 && index.limiters(1) == 0);
+        expect(index.quoted());
+
+        // The quoted area opened above is closed by the next chunk
+        s = cell_string(64, 'x');
+        s[0] = '"'; s[1] = ','; s[2] = '\n'; s[3] = '"'; s[4] = '"'; s[5] = ','; s[6] = '\n';
+        index.build(s);
+        expect(index.size() == 1);
+        expect(index.delimiters(0) == 0b100010);
+        expect(index.lfs(0) == 0b1000100);
+        expect(!index.quoted());
+    };
+
     "Reader callback calculates cells from char const *"_test = [] {
 
         auto cells{0u};
@@ -179,6 +370,18 @@ int main() {
         expect(v.size() == 6);
         expect(v.back() == "six");
 
+        // A header being the only row lacking line feed is a header to its last field
+        std::vector<cell_string> h;
+        v.clear();
+        reader("a,b").run([&](auto s) { h.emplace_back(s); }, [&](auto s) { v.emplace_back(s); });
+        expect(h == std::vector<cell_string>{"a", "b"});
+        expect(v.empty());
+
+        h.clear();
+        reader("a,b").run_span([&](auto & s) { h.emplace_back(); s.read_value(h.back()); },
+                               [&](auto & s) { v.emplace_back(); s.read_value(v.back()); });
+        expect(h == std::vector<cell_string>{"a", "b"});
+        expect(v.empty());
     };
 
     "Reader with another delimiter character"_test = [] {
@@ -304,6 +507,887 @@ int main() {
 
     };
 
+    "Fields straddling source chunks are parsed as a whole"_test = [] {
+
+        // 13-byte rows never fit 64K chunks evenly, so quoted fields with inner limiters fall on chunk edges
+        cell_string src;
+        constexpr auto rows_number = 30000u;
+        for (auto i = 0u; i < rows_number; i++) {
+            src += "\"a,\nb\",\"\"x\"\"\n";
+        }
+        src += "last,\"";
+
+        reader r(src);
+        expect(r.rows() == rows_number);
+        expect(r.cols() == 2);
+
+        auto cells{0u}, rows{0u};
+        auto unexpected{0u};
+        r.run([&](auto s) {
+            if (cells < rows_number * 2) {
+                unexpected += (cells & 1) ? (s != R"("x")") : (s != "a,\nb");
+            }
+            cells++;
+        }, [&] {
+            rows++;
+        });
+        // Unclosed quoted field at the end of the source is not reported
+        expect(cells == rows_number * 2 + 1);
+        expect(rows == rows_number);
+        expect(unexpected == 0);
+
+        cells = rows = unexpected = 0;
+        r.run_span([&](auto & s) {
+            cell_string value;
+            s.read_value(value);
+            if (cells < rows_number * 2) {
+                unexpected += (cells & 1) ? (value != R"("x")") : (value != "a,\nb");
+            }
+            cells++;
+        }, [&] {
+            rows++;
+        });
+        expect(cells == rows_number * 2 + 1);
+        expect(rows == rows_number);
+        expect(unexpected == 0);
+
+    };
+
+    "Views of spans give values read_value() gives"_test = [] {
+
+        auto const src = " a , b\t,\"q\"\"x\" ,  \" c \" ,\n,\"\",  ,d\"e\"f,\"x\ny\"\n last ";
+        auto check = [&src](auto r) {
+            std::vector<cell_string> values, views;
+            cell_string buffer;
+            auto copies {0u};
+            r.run_span([&](auto & s) {
+                values.emplace_back();
+                s.read_value(values.back());
+                auto const v = s.view(buffer);
+                views.emplace_back(v);
+                copies += std::less_equal<>{}(buffer.data(), v.data()) &&
+                          std::less_equal<>{}(v.data(), buffer.data() + buffer.size());
+                if constexpr (requires { s.view(); }) {
+                    if (!s.quoted()) {
+                        expect(s.view() == values.back());
+                    }
+                }
+            });
+            expect(views == values) << src;
+            return copies;
+        };
+        // Only fields with quotes are copied to the buffer
+        expect(check(reader(src)) == 5);
+        expect(check(reader<trim_policy::alltrim>(src)) == 5);
+
+        // Trimming policies trimming strings only have all values copied
+        struct lead_trimming {
+            static void trim (cell_string & s) { s.erase(0, s.find_first_not_of(' ')); }
+        };
+        expect(check(reader<lead_trimming>(src)) == 11);
+
+        // Unescaped into a buffer of a field's size at least
+        std::array<char, 16> buffer {};
+        std::vector<cell_string> values;
+        reader<trim_policy::alltrim>(src).run_span([&](auto & s) { values.emplace_back(s.unescape(buffer)); });
+        expect(values == std::vector<cell_string>{"a", "b", "q\"x", "c", "", "", "", "", "d\"e\"f", "x\ny", "last"});
+        expect(throws([] { reader("abc").run_span([](auto & s) { std::array<char, 2> small {}; (void)s.unescape(small); }); }));
+    };
+
+    "Runs over selected columns only"_test = [] {
+
+        reader r("id,name, price ,qty\n1,\"a, b\",10,x\n2,c,\"2\"\"0\",y\n3,d,30,z");
+        std::vector<cell_string> v;
+        auto rows {0u};
+        auto value = [&v](auto s) { v.emplace_back(s); };
+        auto span = [&v](auto & s) { v.emplace_back(); s.read_value(v.back()); };
+        auto row = [&rows] { rows++; };
+
+        // By numbers, in order of rows
+        r.run({3, 1}, value, row);
+        expect(v == std::vector<cell_string>{"name", "qty", "a, b", "x", "c", "y", "d", "z"});
+        expect(rows == 4);
+
+        v.clear();
+        r.run_span(columns{std::vector<std::size_t>{2, 9}}, span);
+        expect(v == std::vector<cell_string>{" price ", "10", "2\"0", "30"});
+
+        // By names, the first row being a header
+        v.clear();
+        std::vector<cell_string> h;
+        rows = 0;
+        r.run({" price ", "id"}, [&h](auto s) { h.emplace_back(s); }, value, row);
+        expect(h == std::vector<cell_string>{"id", " price "});
+        expect(v == std::vector<cell_string>{"1", "10", "2", "2\"0", "3", "30"});
+        expect(rows == 4);
+
+        v.clear();
+        r.run_span({"qty"}, span);
+        expect(v == std::vector<cell_string>{"x", "y", "z"});
+
+        // Names of the header are ready values
+        v.clear();
+        reader<trim_policy::alltrim>(" a , \"b\" \n1,2\n").run({"b"}, value);
+        expect(v == std::vector<cell_string>{"2"});
+
+        // The last name of a header being the only row lacking LF
+        v.clear();
+        std::vector<cell_string> only;
+        reader("a,b").run({"b"}, [&only](auto s) { only.emplace_back(s); }, value);
+        expect(only == std::vector<cell_string>{"b"});
+        reader("a,b").run({"b"}, value);
+        expect(v.empty());
+
+        expect(throws([&r] { r.run({"id", "missing"}, [](auto) {}); }));
+    };
+
+    "Callbacks may skip rows and stop runs"_test = [] {
+
+        reader r("h1,h2,h3\n1,2,3\n4,5,6\n7,8,9\n");
+        std::vector<cell_string> v;
+        auto row_ends {0u};
+
+        // The first value of each row only, the header's too
+        r.run([&v](auto s) { v.emplace_back(s); return control::skip_row; }, [&row_ends] { row_ends++; });
+        expect(v == std::vector<cell_string>{"h1", "1", "4", "7"});
+        expect(row_ends == 4);
+
+        // A head -n style run
+        v.clear();
+        row_ends = 0;
+        r.run_span([&v](auto & s) { v.emplace_back(); s.read_value(v.back()); },
+                   [&row_ends] { return ++row_ends == 2 ? control::stop : control::next; });
+        expect(v == std::vector<cell_string>{"h1", "h2", "h3", "1", "2", "3"});
+        expect(row_ends == 2);
+
+        // The first matching row, no more fields nor row ends delivered after it
+        v.clear();
+        row_ends = 0;
+        r.run([](auto) {}, [&v](auto s) { v.emplace_back(s); return s == "5" ? control::stop : control::next; },
+              [&row_ends] { row_ends++; });
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4", "5"});
+        expect(row_ends == 2);
+
+        // Selected columns
+        v.clear();
+        r.run({"h3"}, [](auto) {}, [&v](auto s) { v.emplace_back(s); return control::stop; });
+        expect(v == std::vector<cell_string>{"3"});
+
+        // Runs stopped leave dimensions alone
+        expect(r.rows() == 4);
+
+        // Streamed sources stop reading
+        std::istringstream in("a,b\n1,2\n3,4\n");
+        reader s(in);
+        auto fields {0u};
+        s.run_span([&fields](auto &) { return ++fields == 3 ? control::stop : control::next; });
+        expect(fields == 3);
+    };
+
+    "Row mode delivers all fields of a row at once"_test = [] {
+
+        auto rows = [](auto & r) {
+            std::vector<cell_string> v;
+            auto n {0u};
+            auto all_fields {true};
+            r.run_rows([&](auto row) {
+                all_fields = all_fields && row.size() == 3;
+                for (auto const & s : row) {
+                    v.emplace_back();
+                    s.read_value(v.back());
+                }
+                n++;
+            });
+            return std::tuple {v, n, all_fields};
+        };
+
+        auto const src = straddling_rows();
+        auto const expected = std::tuple {span_values(reader(src)), 20003u, true};
+        for_each_reader(src, [&](auto & r, auto const & kind) {
+            expect(rows(r) == expected) << kind;
+            expect(r.rows() == 20003) << kind;
+        });
+
+        // Header row, columns indexed directly, and a stop
+        reader r("name,qty\na,1\nb,2\nc,3\n");
+        std::vector<cell_string> h, v;
+        r.run_rows([&h](auto row) { for (auto const & s : row) { h.emplace_back(); s.read_value(h.back()); } },
+                   [&v](auto row) {
+                       v.emplace_back();
+                       row[1].read_value(v.back());
+                       return v.back() == "2" ? control::stop : control::next;
+                   });
+        expect(h == std::vector<cell_string>{"name", "qty"});
+        expect(v == std::vector<cell_string>{"1", "2"});
+
+        // Rows having fewer fields are delivered as they are, having more - throw
+        auto sizes = std::vector<std::size_t>{};
+        reader("a,b,c\n1,2\n").run_rows([&sizes](auto row) { sizes.push_back(row.size()); });
+        expect(sizes == std::vector<std::size_t>{3, 2});
+        expect(throws([] { reader("a,b\n1,2,3\n").run_rows([](auto) {}); }));
+
+        // A tail inside unclosed quotes is not a row, whatever its fields
+        sizes.clear();
+        reader("1\n2\n3\na,b,\"xx").run_rows([&sizes](auto row) { sizes.push_back(row.size()); });
+        expect(sizes == std::vector<std::size_t>{1, 1, 1});
+    };
+
+    "Block mode delivers rows by columns"_test = [] {
+
+        // Fields in order of rows, and sizes of blocks
+        auto blocks = [](auto & r, std::size_t size) {
+            std::vector<cell_string> v;
+            std::vector<std::size_t> sizes;
+            r.run_blocks(size, [&](auto const & block) {
+                sizes.push_back(block.rows());
+                for (std::size_t row = 0; row < block.rows(); row++) {
+                    for (std::size_t col = 0; col < block.cols(); col++) {
+                        v.emplace_back();
+                        block.field(row, col).read_value(v.back());
+                    }
+                }
+            });
+            return std::pair {v, sizes};
+        };
+
+        auto const src = straddling_rows();
+        auto const expected = span_values(reader(src));
+        for_each_reader(src, [&](auto & r, auto const & kind) {
+            auto const [v, sizes] = blocks(r, 4096);
+            expect(v == expected) << kind;
+            expect(sizes == std::vector<std::size_t>{4096, 4096, 4096, 4096, 3619}) << kind;
+            expect(r.rows() == 20003) << kind;
+        });
+        reader whole(src);
+        expect(blocks(whole, 1).second.size() == 20003);
+        expect(blocks(whole, 1000).second.size() == 21);
+
+        // Offsets and lengths by columns, the header apart, and a stop
+        reader r("id,name\n1,a\n22,\"b\"\"\"\n333,c\n");
+        std::vector<std::size_t> offsets, lengths;
+        std::vector<cell_string> h;
+        auto n {0u};
+        r.run_blocks(2, [&h](auto const & block) {
+            for (std::size_t col = 0; col < block.cols(); col++) {
+                h.emplace_back(block.data() + block.offsets(col)[0], block.lengths(col)[0]);
+            }
+        }, [&](auto const & block) {
+            n++;
+            offsets.assign(block.offsets(1).begin(), block.offsets(1).end());
+            lengths.assign(block.lengths(0).begin(), block.lengths(0).end());
+            return control::stop;
+        });
+        expect(h == std::vector<cell_string>{"id", "name"});
+        expect(n == 1);
+        expect(offsets == std::vector<std::size_t>{2, 7});
+        expect(lengths == std::vector<std::size_t>{1, 2});
+
+        expect(throws([] { reader("a,b\n1,2,3\n").run_blocks(2, [](auto const &) {}); }));
+        expect(throws([] { reader("a,b\n1\n").run_blocks(2, [](auto const &) {}); }));
+        expect(throws([] { reader("a,b\n").run_blocks(0, [](auto const &) {}); }));
+
+        // A tail inside unclosed quotes is not a row, whatever its fields
+        std::vector<std::size_t> sizes;
+        reader("1\n2\n3\na,b,\"xx").run_blocks(2, [&sizes](auto const & block) { sizes.push_back(block.rows()); });
+        expect(sizes == std::vector<std::size_t>{2, 1});
+    };
+
+    "Records are pulled as a range of rows"_test = [] {
+
+        static_assert(std::ranges::input_range<decltype(std::declval<reader<> const &>().records())>);
+
+        auto records = [](auto & r) {
+            std::vector<cell_string> v;
+            auto rows {0u};
+            for (auto const & row : r.records()) {
+                for (auto const & s : row) {
+                    v.emplace_back();
+                    s.read_value(v.back());
+                }
+                rows++;
+            }
+            return std::pair {v, rows};
+        };
+
+        auto const src = straddling_rows();
+        auto const expected = std::pair {span_values(reader(src)), 20003u};
+        for_each_reader(src, [&](auto & r, auto const & kind) {
+            expect(records(r) == expected) << kind;
+            expect(r.rows() == 20003) << kind;
+        });
+
+        // Composed with views, and stopping lazily
+        reader r("name,qty\na,1\nb,2\nc,3\nd,4\n");
+        auto recs = r.records();
+        std::vector<cell_string> v;
+        for (auto const & row : recs | std::views::drop(1)
+                                     | std::views::filter([](auto const & row) { return row[1].view() != "2"; })
+                                     | std::views::take(2)) {
+            v.emplace_back(row[0].view());
+        }
+        expect(v == std::vector<cell_string>{"a", "c"});
+
+        std::istringstream big(src);
+        reader head(big);
+        auto first = head.records();
+        expect(std::ranges::distance(first | std::views::take(3)) == 3);
+        expect(head.rows() == 0); // not read to the end
+
+        reader single("h");
+        auto one = single.records();
+        expect(std::ranges::distance(one) == 1);
+    };
+
+    "Typed values of fields by std::from_chars"_test = [] {
+
+        std::int64_t i {-1};
+        double d {0};
+        expect(string_functions::to_number("-9223372036854775808", i) == std::errc{});
+        expect(i == std::numeric_limits<std::int64_t>::min());
+        expect(string_functions::to_number("9223372036854775808", i) == std::errc::result_out_of_range && i == 0);
+        expect(string_functions::to_number("12x", i) == std::errc::invalid_argument && i == 0);
+        expect(string_functions::to_number("", i) == std::errc::invalid_argument);
+        expect(string_functions::to_number("2.5e3", d) == std::errc{} && d == 2500.0);
+
+        reader r("id,price,name\n1,\" 2.5\",a\n-3,\"1e2\",\"b\"\"\"\nx, 4,c\n");
+        std::vector<std::int64_t> ids;
+        std::vector<double> prices;
+        std::vector<std::errc> errors;
+        r.run_rows([](auto) {}, [&](auto row) {
+            std::errc error {};
+            ids.push_back(row[0].template as<std::int64_t>(error));
+            errors.push_back(error);
+            prices.push_back(row[1].template as<double>(error));
+            errors.push_back(error);
+        });
+        expect(ids == std::vector<std::int64_t>{1, -3, 0});
+        // Untrimmed fields have spaces left, which are not a part of a number
+        expect(prices == std::vector<double>{0, 100, 0});
+        expect(errors == std::vector<std::errc>{std::errc{}, std::errc::invalid_argument, std::errc{}, std::errc{},
+                                                std::errc::invalid_argument, std::errc::invalid_argument});
+
+        // Trimmed and unquoted fields, into numbers and strings
+        reader<trim_policy::alltrim> t(" 7 ,\" 2.5 \",\"1\"\"\"\n");
+        std::vector<double> numbers;
+        cell_string name;
+        auto failed {0u};
+        t.run_span([&](auto & s) {
+            try {
+                numbers.push_back(s.template read_value<double>());
+            } catch (reader<trim_policy::alltrim>::exception const & e) {
+                failed++;
+                expect(cell_string(e.what()).starts_with("Field \"\"1\"\"\"\" is not a number"));
+                s.read_value(name);
+            }
+        });
+        expect(numbers == std::vector<double>{7, 2.5});
+        expect(failed == 1 && name == "1\"");
+
+        unsigned u {0};
+        reader("42").run_span([&u](auto & s) { s.read_value(u); });
+        expect(u == 42);
+    };
+
+    "Reader takes any callables as well as std::function callbacks"_test = [] {
+
+        reader r("h1,h2\n1,2\n3,4\n");
+
+        // Move-only callables are only taken by the template overloads
+        auto fields = [p = std::make_unique<unsigned>(0)](auto const &) { return ++*p; };
+        auto rows = [p = std::make_unique<unsigned>(0)] { return ++*p; };
+        r.run_span(fields, rows);
+        r.run(fields, rows);
+        expect(fields(0) == 13 && rows() == 7);
+
+        std::vector<cell_string> h, v;
+        auto row_ends {0u};
+        std::function<void (std::string_view)> const hfcb = [&h](auto s) { h.emplace_back(s); };
+        std::function<void (std::string_view)> const fcb = [&v](auto s) { v.emplace_back(s); };
+        std::function<void ()> const nrc = [&row_ends] { row_ends++; };
+        r.run(hfcb, fcb, nrc);
+        expect(h == std::vector<cell_string>{"h1", "h2"});
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4"});
+        expect(row_ends == 3);
+
+        h.clear(); v.clear();
+        r.run_span([&h](auto & s) { h.emplace_back(); s.read_value(h.back()); },
+                   [&v](auto & s) { v.emplace_back(); s.read_value(v.back()); });
+        expect(h == std::vector<cell_string>{"h1", "h2"});
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4"});
+    };
+
+    "run_span_parallel() parses parts of whole rows concurrently"_test = [] {
+
+        // Quoted LFs everywhere, and a quoted field longer than a part in the middle
+        cell_string src {"head1,head2\n"};
+        for (auto i = 0u; i < 60000; i++) {
+            src += '"';
+            src += std::to_string(i);
+            src += ",\n";
+            src.append(i % 7 * 2, '"');
+            src += "\",";
+            src += std::to_string(i);
+            src += '\n';
+            if (i == 30000) {
+                src += "\"";
+                for (auto j = 0u; j < 100000; j++) {
+                    src += ",\n";
+                }
+                src += "\",huge\n";
+            }
+        }
+        src += "last,row";
+
+        reader r(src);
+        std::vector<cell_string> expected_headers, expected;
+        auto expected_rows {0u};
+        r.run_span([&](auto & s) {
+            expected_headers.emplace_back();
+            s.read_value(expected_headers.back());
+        }, [&](auto & s) {
+            expected.emplace_back();
+            s.read_value(expected.back());
+        }, [&] {
+            expected_rows++;
+        });
+
+        for (auto threads : {1u, 2u, 3u, 8u, 31u}) {
+            std::vector<std::vector<cell_string>> values (threads);
+            std::vector<unsigned> rows (threads);
+            std::vector<cell_string> headers;
+            r.run_span_parallel(threads, [&](auto & s) {
+                headers.emplace_back();
+                s.read_value(headers.back());
+            }, [&](auto & s, auto part) {
+                values[part].emplace_back();
+                s.read_value(values[part].back());
+            }, [&](auto part) {
+                rows[part]++;
+            });
+            std::vector<cell_string> all;
+            for (auto const & v : values) {
+                all.insert(all.end(), v.begin(), v.end());
+            }
+            expect(headers == expected_headers);
+            expect(all == expected) << "threads:" << threads;
+            expect(std::accumulate(rows.begin(), rows.end(), 0u) == expected_rows);
+        }
+
+        expect(throws([&r] {
+            r.run_span_parallel(4, [](auto &, auto part) {
+                if (part == 2) {
+                    throw std::runtime_error("Stop");
+                }
+            });
+        }));
+    };
+
+    "Stream sources are parsed by chunks as strings are"_test = [] {
+
+        // Quoted LFs, a field longer than a chunk, and the last row lacking LF
+        cell_string src {"h1,h2,h3\n"};
+        for (auto i = 0u; i < 30000; i++) {
+            src += std::to_string(i) + ",\"" + std::to_string(i) + "\n\"\"\",";
+            if (i == 15000) {
+                src += cell_string(200000, 'x');
+            }
+            src += "\n";
+        }
+        src += "a,b,";
+
+        auto spans = [](auto & r) {
+            std::vector<cell_string> h, v;
+            auto rows {0u};
+            r.run_span([&h](auto & s) { h.emplace_back(); s.read_value(h.back()); },
+                       [&v](auto & s) { v.emplace_back(); s.read_value(v.back()); }, [&rows] { rows++; });
+            return std::tuple {h, v, rows};
+        };
+        auto values = [](auto & r) {
+            std::vector<cell_string> h, v;
+            auto rows {0u};
+            r.run([&h](auto s) { h.emplace_back(s); }, [&v](auto s) { v.emplace_back(s); }, [&rows] { rows++; });
+            return std::tuple {h, v, rows};
+        };
+
+        reader whole(src);
+        auto const expected_spans = spans(whole);
+        auto const expected_values = values(whole);
+        expect(std::get<2>(expected_spans) == 30002 && std::get<1>(expected_spans).back().empty());
+
+        std::istringstream in1(src), in2(src), in3(src), in4(src);
+        reader r1(in1), r2(in2), r3(in3), r4(in4);
+        expect(r1.rows() == 0);
+        expect(spans(r1) == expected_spans);
+        expect(r1.rows() == 30002);
+        expect(values(r2) == expected_values);
+        expect(r3.run_span_valid([](auto &) {}) == 30002);
+        expect(r3.cols() == 3);
+        expect(r4.run_valid([](auto) {}) == 30002);
+
+        // The last row lacking LF ends with a delimiter, nothing being carried after the last chars taken
+        std::istringstream tail1("a,b,"), tail2("a,b,");
+        expect(span_values(reader(tail1)) == std::vector<cell_string>{"a", "b", ""});
+        expect(span_values(reader(stream_source{tail2, read_ahead{}})) == std::vector<cell_string>{"a", "b", ""});
+
+        // A stream is read once
+        expect(throws([&r1] { auto &_ = r1.valid(); (void) _; }));
+        expect(throws([&r1] { r1.index_rows(); }));
+        expect(throws([&r1] { r1.run_span_parallel(2, [](auto &, auto) {}); }));
+
+#ifndef _WIN32
+        int fds[2];
+        expect(pipe(fds) == 0);
+        std::thread writer([&src, fd = fds[1]] {
+            for (std::size_t done = 0; done < src.size(); ) {
+                auto const n = write(fd, src.data() + done, std::min<std::size_t>(src.size() - done, 1000));
+                if (n <= 0) {
+                    break;
+                }
+                done += static_cast<std::size_t>(n);
+            }
+            close(fd);
+        });
+        reader piped(stream_source{fds[0]});
+        expect(spans(piped) == expected_spans);
+        writer.join();
+        close(fds[0]);
+#endif
+
+        // Reading ahead, on a thread of its own
+        for (auto ahead : {read_ahead{}, read_ahead{3, 1000}, read_ahead{1, 1}}) {
+            std::istringstream in5(src), in6(src);
+            reader r5(stream_source{in5, ahead}), r6(stream_source{in6, ahead});
+            expect(spans(r5) == expected_spans) << "buffers:" << ahead.buffers << "size:" << ahead.buffer_size;
+            expect(values(r6) == expected_values);
+        }
+
+#ifndef _WIN32
+        // Files read with several reads in flight
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_file_reads_test.csv";
+        {
+            std::ofstream out (csv, std::ios::binary | std::ios::trunc);
+            out << src;
+        }
+        for (auto reads : {in_flight{}, in_flight{3, 1000}, in_flight{1, 7}}) {
+            reader r7(stream_source{csv, reads}), r8(stream_source{csv, reads});
+            expect(spans(r7) == expected_spans) << "reads:" << reads.reads << "size:" << reads.read_size;
+            expect(values(r8) == expected_values);
+        }
+        std::filesystem::remove(csv);
+        expect(throws([&csv] { reader r9(stream_source{csv}); }));
+#endif
+
+        // A source read in part stops its reading thread
+        std::istringstream in7(src);
+        expect(throws([&in7] {
+            reader(stream_source{in7, read_ahead{2, 100}}).run([](auto) { throw std::runtime_error("Stop"); });
+        }));
+    };
+
+    "Readers run concurrently on their own threads"_test = [] {
+
+        std::vector<unsigned> sums (8);
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t < sums.size(); t++) {
+            threads.emplace_back([t, &sums] {
+                cell_string src;
+                for (auto i = 0u; i < 20000; i++) {
+                    src += std::to_string(t) + ",\"" + std::to_string(i) + "\"\n";
+                }
+                for (auto pass = 0u; pass < 3; pass++) {
+                    reader r(src);
+                    auto sum {0u};
+                    r.run([&sum](auto s) { sum += std::stoul(cell_string(s)); });
+                    r.run_span([&sum](auto & s) { cell_string v; s.read_value(v); sum += std::stoul(v); });
+                    sums[t] = (r.cols() == 2 && r.rows() == 20000) ? sum : 0;
+                }
+            });
+        }
+        for (auto & t : threads) {
+            t.join();
+        }
+        for (auto t = 0u; t < sums.size(); t++) {
+            expect(sums[t] == 2 * (t * 20000 + 19999 * 20000 / 2)) << "thread:" << t;
+        }
+
+        // Records begun by a thread are walked to the end and destroyed by another one
+        reader r("a,b\n1,2\n3,4\n");
+        auto records = std::make_optional(r.records());
+        auto rows = static_cast<std::size_t>(std::ranges::distance(*records | std::views::take(1)));
+        std::thread([&] {
+            rows += static_cast<std::size_t>(std::ranges::distance(*records));
+            records.reset();
+        }).join();
+        expect(rows == 3);
+        expect(r.rows() == 3);
+    };
+
+    "Row index gives random access to rows"_test = [] {
+
+        // A quoted field with LFs in row 1, the last row lacks LF
+        reader r("a,b\n\"x\ny\",z\n\n1,\"2,\"\"\n\"\"\"");
+        expect(r.index_rows() == 4);
+        expect(r.rows() == 4);
+
+        auto values = [&r](std::size_t first, std::size_t last) {
+            std::vector<cell_string> v;
+            auto rows {0u};
+            r.rows(first, last, [&v](auto & s) { v.emplace_back(); s.read_value(v.back()); }, [&rows] { rows++; });
+            v.push_back(std::to_string(rows));
+            return v;
+        };
+        expect(values(1, 2) == std::vector<cell_string>{"x\ny", "z", "1"});
+        expect(values(3, 4) == std::vector<cell_string>{"1", "2,\"\n\"", "1"});
+        expect(values(2, 4) == std::vector<cell_string>{"", "1", "2,\"\n\"", "2"});
+        expect(values(0, 0) == std::vector<cell_string>{"0"});
+
+        std::vector<cell_string> first;
+        r.row(0, [&first](auto & s) { first.emplace_back(); s.read_value(first.back()); });
+        expect(first == std::vector<cell_string>{"a", "b"});
+
+        expect(throws([&r] { r.row(4, [](auto &) {}); }));
+        expect(throws([&r] { r.rows(3, 2, [](auto &) {}); }));
+
+        // The index is built on demand, and in parallel it is the same
+        cell_string src;
+        for (auto i = 0u; i < 50000; i++) {
+            src += std::to_string(i) + ",\"" + std::to_string(i) + "\n\"\n";
+        }
+        reader big(src);
+        cell_string value;
+        big.row(40000, [&value](auto & s) { s.read_value(value); });
+        expect(value == "40000\n");
+        for (auto threads : {2u, 3u, 8u}) {
+            reader other(src);
+            expect(other.index_rows(threads) == 50000);
+            other.row(40000, [&value](auto & s) { s.read_value(value); });
+            expect(value == "40000\n") << "threads:" << threads;
+        }
+
+        reader r2 = std::move(big);
+        expect(throws([&big] { big.row(0, [](auto &) {}); }));
+
+        // A source ending inside quotes has no row there, whichever is called first
+        for (auto threads : {1u, 2u}) {
+            reader unclosed("a,\"b\nc");
+            expect(unclosed.index_rows(threads) == 0) << "threads:" << threads;
+            expect(unclosed.rows() == 0);
+            reader tail("a\n\"b");
+            expect(tail.rows() == 1);
+            expect(tail.index_rows(threads) == 1);
+        }
+    };
+
+    "Compressed files are decompressed by chunks as they are parsed"_test = [] {
+
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_compressed_test.csv.gz";
+        cell_string src;
+        for (auto i = 0; i < 3000; i++) {
+            src += std::to_string(i) + ",\"quoted\n" + std::to_string(i) + "\"," + cell_string(i % 97, 'x') + '\n';
+        }
+        src += "last,row";
+        auto spans = [](auto & r) {
+            std::vector<cell_string> v;
+            r.run_span([&v](auto & s) { v.emplace_back(); s.read_value(v.back()); });
+            return v;
+        };
+        auto values = [](auto & r) {
+            std::vector<cell_string> v;
+            r.run([&v](auto value) { v.emplace_back(value); });
+            return v;
+        };
+        reader plain(src);
+        auto const expected_spans = spans(plain);
+        auto const expected_values = values(plain);
+
+#if defined(CSV_CO_ZLIB)
+        // Two gzip members, as of concatenated files
+        auto const half = src.size() / 2;
+        for (auto const & [mode, from, to] : {std::tuple{"wb", std::size_t{0}, half}, std::tuple{"ab", half, src.size()}}) {
+            auto const gz = gzopen(csv.string().c_str(), mode);
+            gzwrite(gz, src.data() + from, static_cast<unsigned>(to - from));
+            gzclose(gz);
+        }
+        expect(compression_of(csv) == compression::gzip);
+        for (auto how : {decompress{}, decompress{read_ahead{0, 0}}, decompress{read_ahead{3, 1000}}}) {
+            reader r1(csv), r2(stream_source{csv, how}), r3(stream_source{csv, how});
+            expect(spans(r1) == expected_spans);
+            expect(spans(r2) == expected_spans) << "buffers:" << how.ahead.buffers;
+            expect(values(r3) == expected_values);
+            expect(r1.rows() == plain.rows());
+        }
+
+        // A member cut short is a read error
+        std::filesystem::resize_file(csv, std::filesystem::file_size(csv) - 10);
+        expect(throws([&csv] { reader(csv).run_span([](auto &) {}); }));
+#else
+        {
+            std::ofstream out (csv, std::ios::binary | std::ios::trunc);
+            out << "\x1f\x8b\x08" << src;
+        }
+        expect(compression_of(csv) == compression::gzip);
+        expect(throws([&csv] { reader r(csv); }));
+#endif
+        std::filesystem::remove(csv);
+    };
+
+    "Sidecar index file is taken by readers of the same file"_test = [] {
+
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_sidecar_test.csv";
+        auto const sidecar = reader<>::index_path(csv);
+        std::filesystem::remove(sidecar);
+        auto write = [&csv](cell_string const & content) {
+            std::ofstream out (csv, std::ios::binary | std::ios::trunc);
+            out << content;
+        };
+        auto second_row = [](auto & r) {
+            std::vector<cell_string> v;
+            r.row(1, [&v](auto & s) { v.emplace_back(); s.read_value(v.back()); });
+            return v;
+        };
+
+        write("a,b\n\"1\n\",2\n3,4");
+        {
+            reader r(csv);
+            r.save_index();
+        }
+        expect(std::filesystem::exists(sidecar));
+        {
+            reader r(csv);
+            expect(r.rows() == 3);
+            expect(second_row(r) == std::vector<cell_string>{"1\n", "2"});
+        }
+
+        // The sidecar is trusted while the file's size and time stay the same
+        auto const time = std::filesystem::last_write_time(csv);
+        write("a\nb\nc\nd\ne\nf\ng\n");
+        std::filesystem::last_write_time(csv, time);
+        expect(reader(csv).rows() == 3);
+
+        // A stale sidecar (of another size of the file) is ignored
+        write("a,b\n5,6\n");
+        {
+            reader r(csv);
+            expect(r.rows() == 2);
+            expect(second_row(r) == std::vector<cell_string>{"5", "6"});
+        }
+
+        // A sidecar of a file ending inside unclosed quotes is taken as well (the same size and time again)
+        write("a\nb\n\"xx");
+        reader(csv).save_index();
+        auto const unclosed_time = std::filesystem::last_write_time(csv);
+        write("a,b\n\"xx");
+        std::filesystem::last_write_time(csv, unclosed_time);
+        expect(reader(csv).rows() == 2);
+
+        // A sidecar having fewer offsets than it tells is ignored
+        write("a,b\n5,6\n7,8\n");
+        reader(csv).save_index();
+        std::filesystem::resize_file(sidecar, 6 * sizeof(std::uint64_t)); // the key, the count and an offset
+        {
+            std::fstream out (sidecar, std::ios::binary | std::ios::in | std::ios::out);
+            out.seekp(4 * sizeof(std::uint64_t));
+            std::uint64_t const offsets {13};
+            out.write(reinterpret_cast<char const *>(&offsets), sizeof(offsets));
+        }
+        expect(nothrow([&csv] { expect(reader(csv).rows() == 3); }));
+
+        // Only files have sidecars
+        expect(throws([] { reader("1,2").save_index(); }));
+
+        std::filesystem::remove(sidecar);
+        std::filesystem::remove(csv);
+    };
+
+    "Access hints of mapped files do not change results"_test = [] {
+
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_hints_test.csv";
+        {
+            // Chunks enough to be dropped behind, fields straddling them
+            std::ofstream out (csv, std::ios::binary | std::ios::trunc);
+            for (auto i = 0; i < 20000; i++) {
+                out << i << ",\"quoted\n" << i << "\", " << cell_string(i % 97, 'x') << '\n';
+            }
+        }
+        auto spans = [](auto & r) {
+            std::size_t total {0};
+            std::size_t rows {0};
+            r.run_span([&total](auto & s) { cell_string v; s.read_value(v); total += v.size(); },
+                       [&rows] { rows++; });
+            return std::pair{total, rows};
+        };
+        auto values = [](auto & r) {
+            std::size_t total {0};
+            r.run([&total](auto value) { total += value.size(); });
+            return total;
+        };
+
+        reader plain(csv);
+        auto const expected_spans = spans(plain);
+        auto const expected_values = values(plain);
+        expect(expected_spans.second == 20000);
+        for (auto hints : {mio::access_hints{.sequential = true, .drop_consumed = true},
+                           mio::access_hints{.will_need = true, .populate = true, .huge_pages = true},
+                           mio::access_hints{true, true, true, true, true}}) {
+            reader r(csv, hints);
+            expect(r.cols() == 3);
+            expect(r.rows() == 20000);
+            expect(spans(r) == expected_spans);
+            expect(values(r) == expected_values);
+            expect(r.valid().run_span_valid([](auto &) {}) == 20000);
+        }
+        std::filesystem::remove(csv);
+    };
+
+    "Files mapped by windows are parsed as mapped ones are"_test = [] {
+
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_windows_test.csv";
+        auto write = [&csv](auto const & fill) {
+            std::ofstream out (csv, std::ios::binary | std::ios::trunc);
+            fill(out);
+        };
+        auto spans = [](auto & r) {
+            std::vector<cell_string> v;
+            std::size_t rows {0};
+            r.run_span([&v](auto & s) { v.emplace_back(); s.read_value(v.back()); }, [&rows] { rows++; });
+            return std::pair{v, rows};
+        };
+        auto values = [](auto & r) {
+            std::vector<cell_string> v;
+            r.run([&v](auto value) { v.emplace_back(value); });
+            return v;
+        };
+        auto check = [&](std::size_t cols) {
+            reader mapped(csv);
+            auto const expected_spans = spans(mapped);
+            auto const expected_values = values(mapped);
+            // Windows of a page, fields longer than windows, a window larger than the file
+            for (std::size_t size : {1u, 4096u, 10000u, 1u << 30}) {
+                reader r(csv, mio::sliding_window{size});
+                expect(r.cols() == cols) << "window:" << size;
+                expect(r.rows() == mapped.rows());
+                expect(spans(r) == expected_spans);
+                expect(values(r) == expected_values);
+                expect(r.valid().run_span_valid([](auto &) {}) == mapped.rows());
+                expect(throws([&r] { r.row(0, [](auto &) {}); }));
+            }
+        };
+
+        write([](auto & out) {
+            for (auto i = 0; i < 5000; i++) {
+                out << i << ",\"quoted\n" << i << "\"," << cell_string(i % 97, 'x') << '\n';
+            }
+            out << "last,\"" << cell_string(30000, 'y') << "\",row";
+        });
+        check(3);
+
+        write([](auto & out) { out << "a\n\"" << cell_string(9000, 'z') << '"'; });
+        check(1);
+
+        std::filesystem::remove(csv);
+        expect(throws([&csv] { reader r(csv, mio::sliding_window{}); }));
+    };
+
     // -- Topic change: File processing --
 
     "Read a well-known file"_test = [] {
@@ -428,6 +1512,117 @@ int main() {
         }));
     };
 
+    "Fused validation, row counting and parsing"_test = [] {
+
+        std::vector<cell_string> h, v;
+        auto rows {0u};
+        reader r("a,b,c\n1,2,3\n4,5,6");
+        expect(r.run_valid([&](auto s) { h.emplace_back(s); }, [&](auto s) { v.emplace_back(s); }, [&] { rows++; }) == 3);
+        expect(h == std::vector<cell_string>{"a", "b", "c"});
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4", "5", "6"});
+        expect(rows == 3);
+
+        h.clear(); v.clear();
+        auto value = [](auto & s) { cell_string value; s.read_value(value); return value; };
+        expect(r.run_span_valid([&](auto & s) { h.push_back(value(s)); }, [&](auto & s) { v.push_back(value(s)); }) == 3);
+        expect(h == std::vector<cell_string>{"a", "b", "c"});
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4", "5", "6"});
+
+        // Excess fields are not delivered, missing ones are found at a row end
+        v.clear();
+        auto message = [](auto const & f) {
+            try { f(); } catch (reader<>::exception const & e) { return cell_string(e.what()); }
+            return cell_string{};
+        };
+        expect(message([&] { reader("1,2\n3,4,5\n").run_valid([&](auto s) { v.emplace_back(s); }); })
+            == "Incorrect CSV source format at row 2");
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4"});
+
+        v.clear();
+        expect(message([&] { reader("1,2\n3,4\n5").run_span_valid([&](auto & s) { v.push_back(value(s)); }); })
+            == "Incorrect CSV source format at row 3");
+        expect(v == std::vector<cell_string>{"1", "2", "3", "4", "5"});
+
+        expect(throws([] { reader(std::filesystem::path("game-invalid-format.csv")).run_span_valid([](auto &) {}); }));
+        expect(nothrow([] {
+            expect(reader(std::filesystem::path("game.csv")).run_valid([](auto) {}) == 14);
+        }));
+
+        reader r2 = std::move(r);
+        expect(throws([&r] { r.run_valid([](auto) {}); }));
+        expect(throws([&r] { r.run_span_valid([](auto &) {}); }));
+
+        // An empty stream has no rows, a moved-from one throws as well
+        std::istringstream empty1, empty2;
+        reader e1(empty1), e2(empty2);
+        expect(e1.run_valid([](auto) {}) == 0);
+        expect(e2.run_span_valid([](auto &) {}) == 0);
+        expect(e1.rows() == 0 && e1.cols() == 0);
+        reader e3 = std::move(e2);
+        expect(throws([&e2] { e2.run_valid([](auto) {}); }));
+    };
+
+    "Dimensions are memoized by getters, valid() and full runs"_test = [] {
+
+        // Getters and valid() pass a mapped file once: its chars changed in place afterwards (a shape of the same
+        // size) are seen by new readers only
+        auto const csv = std::filesystem::temp_directory_path() / "csv_co_memo_test.csv";
+        auto const csv2 = std::filesystem::temp_directory_path() / "csv_co_memo_test2.csv";
+        auto write = [](auto const & path, char const * chars, std::ios::openmode mode = std::ios::trunc) {
+            std::ofstream out (path, std::ios::binary | mode);
+            out << chars;
+        };
+        write(csv, "a,b,c\n1,2,3\n4,5,6");
+        write(csv2, "1,2\n3,4\n5,6\n7,8\n");
+
+        reader r(csv);
+        expect(r.cols() == 3 && r.rows() == 3);
+        reader r2(csv2);
+        auto &_ = r2.valid();
+        (void) _;
+#ifndef _WIN32
+        write(csv, "a\nb\nc\n1\n2\n3\n4\n5\n6", std::ios::in);
+        write(csv2, "1,2,3,4\n5,6,7,8\n", std::ios::in);
+        expect(reader(csv).cols() == 1 && reader(csv).rows() == 9);
+#endif
+        expect(r.cols() == 3 && r.rows() == 3);
+        expect(r2.cols() == 2 && r2.rows() == 4);
+
+        // Streams are not read again: their dimensions are what full runs found
+        std::istringstream in3("1,2\n3,4\n5,6");
+        reader r3(in3);
+        r3.run_span([](auto &) {});
+        expect(r3.rows() == 3 && r3.cols() == 2);
+
+        auto dimensions = [](auto run) {
+            std::istringstream in("1,2,3\n4,5,6\n");
+            reader r(in);
+            run(r);
+            return std::pair {r.cols(), r.rows()};
+        };
+        auto const expected = std::pair {std::size_t{3}, std::size_t{2}};
+        expect(dimensions([](auto & r) { r.run([](auto) {}); }) == expected);
+        expect(dimensions([](auto & r) { r.run_rows([](auto) {}); }) == expected);
+        expect(dimensions([](auto & r) { r.run_blocks(2, [](auto const &) {}); }) == expected);
+        expect(dimensions([](auto & r) { for (auto const & record : r.records()) { (void) record; } }) == expected);
+
+        std::istringstream in4("1\n2\n");
+        reader r4(in4);
+        r4.run_valid([](auto) {}, [](auto) {});
+        expect(r4.rows() == 2 && r4.cols() == 1);
+
+        // move-from state object forgets its dimensions, a move-assigned one takes them over
+        r4 = std::move(r);
+        expect(r.cols() == 0 && r.rows() == 0);
+        expect(r4.cols() == 3 && r4.rows() == 3);
+        r = std::move(r2);
+        expect(r2.cols() == 0 && r2.rows() == 0);
+        expect(r.cols() == 2 && r.rows() == 4);
+
+        std::filesystem::remove(csv);
+        std::filesystem::remove(csv2);
+    };
+
     // -- Topic change: Move Operations --
     "Move construction and assignment"_test = [] {
 